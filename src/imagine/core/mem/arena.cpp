@@ -0,0 +1,114 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/mem/arena.h"
+
+#include <utility>
+
+namespace ig {
+
+struct arena::block {
+  block* next;
+  size_t size;
+
+  auto begin() { return reinterpret_cast<char*>(this) + header; }
+  auto end()   { return begin() + size; }
+  static constexpr size_t header = (sizeof(block*) + sizeof(size_t) + max_align - 1) & ~(max_align - 1);
+};
+
+namespace {
+
+char* align_up(char* ptr, size_t alignment) {
+  auto p = reinterpret_cast<uintptr_t>(ptr);
+  return reinterpret_cast<char*>((p + alignment - 1) & ~(alignment - 1));
+}
+
+} // namespace
+
+arena::arena(size_t capacity)
+  : head_{nullptr}
+  , block_{nullptr}
+  , cur_{nullptr}
+  , end_{nullptr}
+  , used_{0}
+  , capacity_{0} {
+
+  if (capacity) grow(capacity, max_align);
+}
+
+arena::~arena() {
+  for (auto b = head_; b;)
+    ::operator delete(std::exchange(b, b->next));
+}
+
+void* arena::do_allocate(size_t bytes, size_t alignment) {
+  auto ptr = align_up(cur_, alignment);
+  if (!cur_ || ptr + bytes > end_) {
+    grow(bytes, alignment);
+    ptr = align_up(cur_, alignment);
+  }
+
+  used_ += (ptr + bytes) - cur_;
+  cur_   =  ptr + bytes;
+  return ptr;
+}
+
+auto arena::grow(size_t bytes, size_t alignment) -> block* {
+  auto fits = [&](block* b) { return align_up(b->begin(), alignment) + bytes <= b->end(); };
+
+  // reuse blocks kept by a previous rewind
+  auto b = block_ ? block_->next : head_;
+  while (b && !fits(b)) b = b->next;
+
+  if (!b) {
+    auto size = std::max(capacity_, bytes + alignment);
+    b = static_cast<block*>(::operator new(block::header + size));
+    b->size = size;
+    if (block_) {
+      b->next = block_->next;
+      block_->next = b;
+    } else {
+      b->next = head_;
+      head_ = b;
+    } capacity_ += size;
+  }
+
+  block_ = b;
+  cur_ = b->begin();
+  end_ = b->end();
+  return b;
+}
+
+void arena::rewind(const mark& m) {
+  block_ = m.at;
+  cur_   = m.cur;
+  end_   = m.at ? m.at->end() : nullptr;
+  used_  = m.used;
+}
+
+void arena::release() {
+  // coalesce the chain so that the next pass fits in a single block
+  if (head_ && head_->next) {
+    auto size = capacity_;
+    for (auto b = head_; b;)
+      ::operator delete(std::exchange(b, b->next));
+
+    head_ = block_ = nullptr;
+    capacity_ = 0;
+    grow(size, max_align);
+  } else if (head_) {
+    block_ = head_;
+    cur_ = head_->begin();
+    end_ = head_->end();
+  } used_ = 0;
+}
+
+arena& arena::local() {
+  thread_local arena a{};
+  return a;
+}
+
+} // namespace ig
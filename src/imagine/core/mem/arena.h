@@ -0,0 +1,68 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_CORE_ARENA_H
+#define IG_CORE_ARENA_H
+
+#include "imagine/core/mem/resource.h"
+
+namespace ig {
+
+// monotonic arena
+// bump allocation over a chain of blocks, deallocation is a no-op
+// frames rewind the arena and keep its blocks for the next iteration
+class IG_API arena : public memory_resource {
+public:
+  struct block;
+  struct mark { block* at; char* cur; size_t used; };
+
+  explicit arena(size_t capacity = 1 << 16);
+  ~arena();
+
+  auto save() const { return mark{block_, cur_, used_}; }
+  void rewind(const mark& m);
+  void release();
+
+  auto used() const { return used_; }
+  auto capacity() const { return capacity_; }
+
+  static arena& local();
+
+  class frame {
+  public:
+    explicit frame(arena& a)
+      : arena_{a}
+      , mark_{a.save()} {}
+    ~frame() { arena_.rewind(mark_); }
+
+    frame(const frame&) = delete;
+    frame& operator=(const frame&) = delete;
+
+  private:
+    arena& arena_;
+    mark mark_;
+  };
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+protected:
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void  do_deallocate(void*, size_t, size_t) override {}
+
+private:
+  auto grow(size_t bytes, size_t alignment) -> block*;
+
+  block* head_;
+  block* block_;
+  char* cur_;
+  char* end_;
+  size_t used_, capacity_;
+};
+
+} // namespace ig
+
+#endif // IG_CORE_ARENA_H
@@ -0,0 +1,50 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_CORE_MAPPING_H
+#define IG_CORE_MAPPING_H
+
+#include "imagine/ig.h"
+
+#include <string>
+
+namespace ig {
+
+// file mapping
+// read   -> read-only view of the file
+// cow    -> private writable view, writes never reach the file
+// shared -> writable view, writes are carried to the file (resized to size when given)
+class IG_API mapping {
+public:
+  enum class mode { read, cow, shared };
+  enum class access { normal, sequential, random, willneed, dontneed };
+
+  explicit mapping(const std::string& path, mode m = mode::read, size_t size = 0);
+  ~mapping();
+
+  auto data() const { return static_cast<const char*>(data_); }
+  auto data()       { return static_cast<char*>(data_); }
+  auto size() const { return size_; }
+  auto writable() const { return mode_ != mode::read; }
+
+  void sync();
+
+  // paging hints and write-back over a range of any mapping, extended to whole pages
+  static void advise(const void* addr, size_t bytes, access a);
+  static void flush(const void* addr, size_t bytes, bool wait = false);
+
+  mapping(const mapping&) = delete;
+  mapping& operator=(const mapping&) = delete;
+
+private:
+  void* data_;
+  size_t size_;
+  mode mode_;
+};
+
+} // namespace ig
+
+#endif // IG_CORE_MAPPING_H
@@ -0,0 +1,78 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/mem/mapping.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ig {
+
+mapping::mapping(const std::string& path, mode m, size_t size)
+  : data_{nullptr}
+  , size_{0}
+  , mode_{m} {
+
+  auto fd = ::open(path.c_str(), m == mode::shared ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+  if (fd < 0) {
+    throw std::runtime_error{
+      "[Mapping] Unable to open " + path + 
+      " (inexistant or inaccessible file)"};
+  }
+
+  struct stat st{};
+  ::fstat(fd, &st);
+  size_ = static_cast<size_t>(st.st_size);
+  if (m == mode::shared && size && size != size_) {
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      ::close(fd);
+      throw std::runtime_error{"[Mapping] Unable to resize " + path};
+    } size_ = size;
+  }
+
+  if (size_) {
+    auto prot  = m == mode::read   ? PROT_READ  : PROT_READ | PROT_WRITE;
+    auto flags = m == mode::shared ? MAP_SHARED : MAP_PRIVATE;
+    data_ = ::mmap(nullptr, size_, prot, flags, fd, 0);
+  } ::close(fd);
+
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    throw std::runtime_error{"[Mapping] Unable to map " + path};
+  }
+}
+
+mapping::~mapping() {
+  if (data_) ::munmap(data_, size_);
+}
+
+void mapping::sync() {
+  if (data_ && mode_ == mode::shared) ::msync(data_, size_, MS_SYNC);
+}
+
+// page-aligned start and length of a range
+static auto page_range(const void* addr, size_t bytes) {
+  static const auto page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+  auto begin = reinterpret_cast<uintptr_t>(addr) / page * page;
+  return std::pair{reinterpret_cast<void*>(begin), reinterpret_cast<uintptr_t>(addr) + bytes - begin};
+}
+
+void mapping::advise(const void* addr, size_t bytes, access a) {
+  static constexpr int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED};
+  if (!bytes) return;
+  auto [begin, length] = page_range(addr, bytes);
+  ::madvise(begin, length, advice[static_cast<int>(a)]);
+}
+
+void mapping::flush(const void* addr, size_t bytes, bool wait) {
+  if (!bytes) return;
+  auto [begin, length] = page_range(addr, bytes);
+  ::msync(begin, length, wait ? MS_SYNC : MS_ASYNC);
+}
+
+} // namespace ig
@@ -0,0 +1,49 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_CORE_PAGES_H
+#define IG_CORE_PAGES_H
+
+#include "imagine/core/mem/resource.h"
+
+namespace ig {
+
+// page-backed resource
+// blocks of at least threshold bytes are mapped directly on huge page boundaries, smaller ones come from the heap
+// transparent -> anonymous mapping advised for transparent huge pages (madvise)
+// huge        -> hugetlb mapping, transparent huge pages when no huge page is reserved
+// mapped pages are committed on first touch, by the thread writing them
+class IG_API page_resource : public memory_resource {
+public:
+  enum class backing { transparent, huge };
+  static constexpr size_t huge_size = size_t(2) << 20;
+
+  explicit page_resource(backing b, size_t threshold = huge_size)
+    : backing_{b}
+    , threshold_{threshold} {}
+
+  static auto get(backing b) -> page_resource&;
+
+protected:
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void  do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+
+private:
+  auto mapped(size_t bytes, size_t alignment) const
+  { return bytes >= threshold_ && alignment <= huge_size; }
+
+  backing backing_;
+  size_t threshold_;
+};
+
+// resource sources, the resource of allocators bound by default construction
+struct current_pages     { static auto get() { return memory_resource::current(); } };
+struct transparent_pages { static auto get() -> memory_resource* { return &page_resource::get(page_resource::backing::transparent); } };
+struct huge_pages        { static auto get() -> memory_resource* { return &page_resource::get(page_resource::backing::huge); } };
+
+} // namespace ig
+
+#endif // IG_CORE_PAGES_H
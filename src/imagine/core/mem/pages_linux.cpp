@@ -0,0 +1,49 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/mem/pages.h"
+
+#include <sys/mman.h>
+
+namespace ig {
+
+auto page_resource::get(backing b) -> page_resource& {
+  // never destroyed, arrays may outlive static destruction
+  static auto transparent = new page_resource{backing::transparent};
+  static auto huge        = new page_resource{backing::huge};
+  return b == backing::huge ? *huge : *transparent;
+}
+
+void* page_resource::do_allocate(size_t bytes, size_t alignment) {
+  if (!mapped(bytes, alignment))
+    return ::operator new(bytes, std::align_val_t{std::max(alignment, max_align)});
+
+  auto length = (bytes + huge_size - 1) & ~(huge_size - 1);
+  if (backing_ == backing::huge) {
+    auto ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) return ptr;
+  }
+
+  // over-mapped by a huge page so that the block starts on a boundary, the slack is given back
+  auto raw = static_cast<char*>(::mmap(nullptr, length + huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (raw == MAP_FAILED) throw std::bad_alloc{};
+
+  auto head = (huge_size - reinterpret_cast<uintptr_t>(raw) % huge_size) % huge_size;
+  if (head) ::munmap(raw, head);
+  ::munmap(raw + head + length, huge_size - head);
+
+  ::madvise(raw + head, length, MADV_HUGEPAGE);
+  return raw + head;
+}
+
+void page_resource::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+  if (!mapped(bytes, alignment)) {
+    ::operator delete(ptr, std::align_val_t{std::max(alignment, max_align)});
+    return;
+  } ::munmap(ptr, (bytes + huge_size - 1) & ~(huge_size - 1));
+}
+
+} // namespace ig
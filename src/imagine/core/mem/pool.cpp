@@ -0,0 +1,107 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/mem/pool.h"
+
+namespace ig {
+
+struct pool::cache {
+  node*  head[classes]{};
+  size_t count[classes]{};
+
+  ~cache() {
+    for (size_t c = 0; c < classes; ++c) {
+      if (!head[c]) continue;
+      auto last = head[c];
+      while (last->next) last = last->next;
+      pool::get().drain(c, head[c], last);
+    }
+  }
+};
+
+auto pool::get() -> pool& {
+  // never destroyed, thread caches may outlive static destruction
+  static auto p = new pool{};
+  return *p;
+}
+
+auto pool::local() -> cache& {
+  thread_local cache c{};
+  return c;
+}
+
+void* pool::do_allocate(size_t bytes, size_t alignment) {
+  auto size = std::max(bytes, alignment);
+  if (size > max_class)
+    return ::operator new(bytes, std::align_val_t{std::max(alignment, max_align)});
+
+  auto  c = class_of(size);
+  auto& l = local();
+  if (!l.head[c]) {
+    l.head[c]  = refill(c, batch);
+    l.count[c] = batch;
+  }
+
+  auto n = l.head[c];
+  l.head[c] = n->next;
+  l.count[c]--;
+  return n;
+}
+
+void pool::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+  auto size = std::max(bytes, alignment);
+  if (size > max_class) {
+    ::operator delete(ptr, std::align_val_t{std::max(alignment, max_align)});
+    return;
+  }
+
+  auto  c = class_of(size);
+  auto& l = local();
+  auto  n = static_cast<node*>(ptr);
+  n->next = l.head[c];
+  l.head[c] = n;
+
+  // return a batch to the central list when the cache grows too large
+  if (++l.count[c] > 2 * batch) {
+    auto first = l.head[c], last = first;
+    for (size_t i = 1; i < batch; ++i) last = last->next;
+    l.head[c] = last->next;
+    l.count[c] -= batch;
+    drain(c, first, last);
+  }
+}
+
+auto pool::refill(size_t c, size_t count) -> node* {
+  std::lock_guard<decltype(mutex_)> lock{mutex_};
+  auto size = min_class << c;
+
+  node* head = nullptr;
+  for (size_t i = 0; i < count; ++i) {
+    if (!free_[c]) {
+      // carve a fresh chunk, aligned on the largest class so every block is aligned on its size
+      auto mem = static_cast<char*>(::operator new(chunk, std::align_val_t{max_class}));
+      chunks_.push_back(mem);
+      for (size_t off = chunk; off >= size; off -= size) {
+        auto n = reinterpret_cast<node*>(mem + off - size);
+        n->next = free_[c];
+        free_[c] = n;
+      }
+    }
+
+    auto n = free_[c];
+    free_[c] = n->next;
+    n->next = head;
+    head = n;
+  } return head;
+}
+
+void pool::drain(size_t c, node* first, node* last) {
+  std::lock_guard<decltype(mutex_)> lock{mutex_};
+  last->next = free_[c];
+  free_[c] = first;
+}
+
+} // namespace ig
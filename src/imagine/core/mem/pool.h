@@ -0,0 +1,59 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_CORE_POOL_H
+#define IG_CORE_POOL_H
+
+#include "imagine/core/mem/resource.h"
+
+#include <mutex>
+#include <vector>
+
+namespace ig {
+
+// size-class pool
+// power-of-two classes up to max_class, served from thread-local caches refilled in batches from a central list
+// larger requests go straight to the global heap
+class IG_API pool : public memory_resource {
+public:
+  static constexpr size_t min_class = 16;
+  static constexpr size_t max_class = 4096;
+  static constexpr size_t classes   = 9;
+  static constexpr size_t chunk     = 1 << 16;
+  static constexpr size_t batch     = 32;
+
+  static auto get() -> pool&;
+  static constexpr auto class_of(size_t bytes) {
+    size_t c = 0;
+    while ((min_class << c) < bytes) ++c;
+    return c;
+  }
+
+  pool(const pool&) = delete;
+  pool& operator=(const pool&) = delete;
+
+protected:
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void  do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+
+private:
+  pool() = default;
+
+  struct node { node* next; };
+  struct cache;
+
+  auto refill(size_t c, size_t count) -> node*;
+  void drain(size_t c, node* first, node* last);
+  static auto local() -> cache&;
+
+  std::mutex mutex_;
+  node* free_[classes]{};
+  std::vector<void*> chunks_;
+};
+
+} // namespace ig
+
+#endif // IG_CORE_POOL_H
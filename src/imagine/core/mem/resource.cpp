@@ -0,0 +1,22 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/mem/resource.h"
+#include "imagine/core/mem/pool.h"
+
+#include <utility>
+
+namespace ig {
+
+static IG_TLS memory_resource* current_ = nullptr;
+
+memory_resource* memory_resource::current()
+{ return current_ ? current_ : &pool::get(); }
+
+memory_resource* memory_resource::exchange(memory_resource* resource)
+{ return std::exchange(current_, resource); }
+
+} // namespace ig
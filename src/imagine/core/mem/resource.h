@@ -0,0 +1,123 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_CORE_RESOURCE_H
+#define IG_CORE_RESOURCE_H
+
+#include "imagine/ig.h"
+
+#include <new>
+
+namespace ig {
+
+// memory resource
+// polymorphic source of raw storage for library containers
+// every thread has a current resource, used by default-constructed allocators (pool when none is installed)
+class IG_API memory_resource {
+public:
+  static constexpr size_t max_align = alignof(std::max_align_t);
+
+  virtual ~memory_resource() = default;
+
+  void* allocate(size_t bytes, size_t alignment = max_align)
+  { return do_allocate(bytes, alignment); }
+  void deallocate(void* ptr, size_t bytes, size_t alignment = max_align)
+  { do_deallocate(ptr, bytes, alignment); }
+
+  static memory_resource* current();
+  static memory_resource* exchange(memory_resource* resource);
+
+protected:
+  virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+  virtual void  do_deallocate(void* ptr, size_t bytes, size_t alignment) = 0;
+};
+
+// installs a resource as the current one for the calling thread until destruction
+// containers built inside the scope keep their resource, which must outlive them
+class resource_scope {
+public:
+  explicit resource_scope(memory_resource& resource)
+    : prev_{memory_resource::exchange(&resource)} {}
+  ~resource_scope() { memory_resource::exchange(prev_); }
+
+  resource_scope(const resource_scope&) = delete;
+  resource_scope& operator=(const resource_scope&) = delete;
+
+private:
+  memory_resource* prev_;
+};
+
+// allocator hook
+// binds to the current resource on construction, copies of containers rebind to the current resource
+template <typename T>
+class allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap            = std::false_type;
+  using is_always_equal                        = std::false_type;
+
+  allocator() noexcept : resource_{memory_resource::current()} {}
+  allocator(memory_resource* resource) noexcept : resource_{resource} {}
+  template <typename U>
+  allocator(const allocator<U>& o) noexcept : resource_{o.resource()} {}
+
+  auto allocate(size_t n)
+  { return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T* ptr, size_t n)
+  { resource_->deallocate(ptr, n * sizeof(T), alignof(T)); }
+
+  auto select_on_container_copy_construction() const { return allocator{}; }
+  auto resource() const { return resource_; }
+
+private:
+  memory_resource* resource_;
+};
+
+// aligned allocator hook
+// blocks aligned on at least Alignment bytes, from the resource of Source (default construction and copies)
+// elements are default-initialized, trivial types are left untouched until first written
+template 
+< typename T, 
+  size_t Alignment, 
+  typename Source >
+class aligned_allocator : public allocator<T> {
+public:
+  template <typename U> 
+  struct rebind { using other = aligned_allocator<U, Alignment, Source>; };
+
+  aligned_allocator() noexcept : allocator<T>{Source::get()} {}
+  aligned_allocator(memory_resource* resource) noexcept : allocator<T>{resource} {}
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment, Source>& o) noexcept : allocator<T>{o.resource()} {}
+
+  auto allocate(size_t n)
+  { return static_cast<T*>(this->resource()->allocate(n * sizeof(T), alignment)); }
+  void deallocate(T* ptr, size_t n)
+  { this->resource()->deallocate(ptr, n * sizeof(T), alignment); }
+
+  template <typename U, typename... Args>
+  void construct(U* ptr, Args&&... args) {
+    if constexpr (!sizeof...(Args)) ::new (static_cast<void*>(ptr)) U;
+    else 
+      ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+  }
+
+  auto select_on_container_copy_construction() const { return aligned_allocator{}; }
+
+private:
+  static constexpr size_t alignment = Alignment > alignof(T) ? Alignment : alignof(T);
+};
+
+template <typename T, typename U>
+bool operator==(const allocator<T>& lhs, const allocator<U>& rhs) { return lhs.resource() == rhs.resource(); }
+template <typename T, typename U>
+bool operator!=(const allocator<T>& lhs, const allocator<U>& rhs) { return lhs.resource() != rhs.resource(); }
+
+} // namespace ig
+
+#endif // IG_CORE_RESOURCE_H
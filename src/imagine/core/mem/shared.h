@@ -0,0 +1,45 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_CORE_SHARED_H
+#define IG_CORE_SHARED_H
+
+#include "imagine/ig.h"
+
+#include <string>
+
+namespace ig {
+
+// named POSIX shared memory segment
+// the reference count lives in the segment itself, so every process holding it (creator or attached)
+// owns one reference, the last one to release it unlinks the name
+// a process that dies without releasing leaks its reference, the segment then outlives every user
+class IG_API shared_segment {
+public:
+  static constexpr size_t header_size = 64;
+
+  explicit shared_segment(size_t bytes);
+  explicit shared_segment(const std::string& name);
+  ~shared_segment();
+
+  auto data() const { return static_cast<const char*>(base_) + header_size; }
+  auto data()       { return static_cast<char*>(base_) + header_size; }
+  auto size() const { return size_; }
+  auto& name() const { return name_; }
+  auto refs() const -> size_t;
+
+  shared_segment(const shared_segment&) = delete;
+  shared_segment& operator=(const shared_segment&) = delete;
+
+private:
+  void* base_;
+  size_t size_;
+  std::string name_;
+};
+
+} // namespace ig
+
+#endif // IG_CORE_SHARED_H
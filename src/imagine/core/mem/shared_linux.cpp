@@ -0,0 +1,129 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/mem/shared.h"
+
+#include <atomic>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ig {
+
+namespace {
+
+constexpr uint32_t segment_magic = 0x49475348; // IGSH
+
+struct segment_header {
+  uint32_t magic;
+  std::atomic<uint32_t> refs;
+  uint64_t bytes;
+};
+
+static_assert(sizeof(segment_header) <= shared_segment::header_size, "Segment header overflows its reserved space");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Cross-process reference count requires lock-free atomics");
+
+auto header(void* base) { return static_cast<segment_header*>(base); }
+
+auto unique_name() {
+  static std::atomic<uint64_t> counter{0};
+  return "/ig-" + std::to_string(::getpid()) + "-" + std::to_string(counter++);
+}
+
+} // namespace
+
+shared_segment::shared_segment(size_t bytes)
+  : base_{nullptr}
+  , size_{bytes}
+  , name_{unique_name()} {
+
+  auto fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) 
+    throw std::runtime_error{"[Shared] Unable to create segment " + name_};
+
+  auto total = header_size + bytes;
+  if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name_.c_str());
+    throw std::runtime_error{"[Shared] Unable to reserve " + std::to_string(total) + " bytes for segment " + name_};
+  }
+
+  base_ = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    ::shm_unlink(name_.c_str());
+    throw std::runtime_error{"[Shared] Unable to map segment " + name_};
+  }
+
+  auto h = new (base_) segment_header{};
+  h->magic = segment_magic;
+  h->refs.store(1, std::memory_order_release);
+  h->bytes = bytes;
+}
+
+shared_segment::shared_segment(const std::string& name)
+  : base_{nullptr}
+  , size_{0}
+  , name_{name} {
+
+  auto fd = ::shm_open(name_.c_str(), O_RDWR, 0600);
+  if (fd < 0) 
+    throw std::runtime_error{"[Shared] Unable to open segment " + name_ + " (released or inexistant)"};
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error{"[Shared] Unable to query segment " + name_};
+  }
+
+  auto total = static_cast<size_t>(st.st_size);
+  if (total < header_size) {
+    ::close(fd);
+    throw std::runtime_error{"[Shared] Segment " + name_ + " is not initialized"};
+  }
+
+  base_ = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    throw std::runtime_error{"[Shared] Unable to map segment " + name_};
+  }
+
+  // the payload announced by the header must lie within the mapping
+  auto h = header(base_);
+  if (h->magic == segment_magic && h->bytes > total - header_size) {
+    ::munmap(base_, total);
+    base_ = nullptr;
+    throw std::runtime_error{"[Shared] Segment " + name_ + " is corrupted (size exceeds its mapping)"};
+  }
+
+  // only join a segment that is still referenced, a zero count means it is being released
+  auto refs = h->refs.load(std::memory_order_acquire);
+  do {
+    if (h->magic != segment_magic || refs == 0) {
+      ::munmap(base_, total);
+      base_ = nullptr;
+      throw std::runtime_error{"[Shared] Segment " + name_ + " was released"};
+    }
+  } while (!h->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acq_rel));
+  size_ = h->bytes;
+}
+
+shared_segment::~shared_segment() {
+  if (!base_) return;
+  if (header(base_)->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) 
+    ::shm_unlink(name_.c_str());
+  ::munmap(base_, header_size + size_);
+}
+
+auto shared_segment::refs() const -> size_t {
+  return header(base_)->refs.load(std::memory_order_acquire);
+}
+
+} // namespace ig
@@ -7,10 +7,128 @@
 #ifndef IG_CORE_DISTRIBUTE_H
 #define IG_CORE_DISTRIBUTE_H
 
-#include "imagine/ig.h"
+#include "imagine/core/net/peer.h"
+#include "imagine/core/mem/shared.h"
+
+#include <cstring>
 
 namespace ig {
 
+// parameter sweep over worker processes, results keep the order of the parameters
+template 
+< typename Callable, 
+  typename Params >
+auto sweep(peer& p, Callable fn, const Params& params) {
+  using param_type  = typename Params::value_type;
+  using return_type = std::invoke_result_t<Callable, param_type>;
+
+  std::vector< std::future<return_type> > futures;
+  futures.reserve(params.size());
+  for (auto& param : params) futures.push_back(p.work(fn, param));
+
+  std::vector<return_type> results;
+  results.reserve(futures.size());
+  for (auto& f : futures) results.push_back(f.get());
+  return results;
+}
+
+// Shared arrays
+// storage lives in a shared_segment, processes exchange handles (segment name, offset, shape) instead of bytes
+// handles do not own the segment, the sender keeps its array alive until the receiving task completes
+// layout is dense with the first dimension fastest, as ndarray
+constexpr size_t shared_dims = 8;
+
+struct shared_handle {
+  char name[48];
+  uint64_t element;
+  uint64_t offset;
+  uint64_t dims;
+  uint64_t shape[shared_dims];
+
+  auto count() const {
+    size_t n = 1;
+    for (size_t i = 0; i < dims; ++i) n *= shape[i];
+    return n;
+  }
+
+  // sub-array of indices [begin, end) along the last (slowest) dimension, contiguous in memory
+  auto slice(size_t begin, size_t end) const {
+    if (begin > end || end > shape[dims - 1])
+      throw std::runtime_error{"[Distribute] Slice out of bounds of the shared array"};
+
+    auto s = *this;
+    s.offset += begin * (count() / shape[dims - 1]);
+    s.shape[dims - 1] = end - begin;
+    return s;
+  }
+};
+
+template <typename T>
+class shared_array {
+public:
+  static_assert(std::is_trivially_copyable_v<T>, "Shared arrays need trivially copyable elements");
+  using value_type = T;
+
+  template <typename Shape>
+  explicit shared_array(const Shape& dims) : handle_{} {
+    if (std::size(dims) == 0 || std::size(dims) > shared_dims)
+      throw std::runtime_error{"[Distribute] Shared arrays hold between 1 and " + std::to_string(shared_dims) + " dimensions"};
+
+    handle_.element = sizeof(T);
+    handle_.dims = std::size(dims);
+    std::copy(std::begin(dims), std::end(dims), handle_.shape);
+    segment_ = std::make_shared<shared_segment>(handle_.count() * sizeof(T));
+    std::strncpy(handle_.name, segment_->name().c_str(), sizeof(handle_.name) - 1);
+  }
+  explicit shared_array(std::initializer_list<size_t> dims) : shared_array{std::vector<size_t>{dims}} {}
+
+  static auto attach(const shared_handle& h) {
+    if (h.element != sizeof(T))
+      throw std::runtime_error{"[Distribute] Shared array element size mismatch (" + std::to_string(h.element) + " stored)"};
+
+    auto segment = std::make_shared<shared_segment>(std::string{h.name});
+    if ((h.offset + h.count()) * sizeof(T) > segment->size())
+      throw std::runtime_error{"[Distribute] Shared handle exceeds segment " + segment->name()};
+    return shared_array{h, std::move(segment)};
+  }
+
+  auto data() const { return reinterpret_cast<const T*>(segment_->data()) + handle_.offset; }
+  auto data()       { return reinterpret_cast<T*>(segment_->data()) + handle_.offset; }
+  auto size() const { return handle_.count(); }
+  auto dims() const { return handle_.dims; }
+  auto shape() const { return std::vector<size_t>(handle_.shape, handle_.shape + handle_.dims); }
+
+  auto& handle() const { return handle_; }
+  auto holder() const { return std::shared_ptr<const void>{segment_}; }
+
+private:
+  explicit shared_array(const shared_handle& h, std::shared_ptr<shared_segment> segment)
+    : handle_{h}
+    , segment_{std::move(segment)} {}
+
+  shared_handle handle_;
+  std::shared_ptr<shared_segment> segment_;
+};
+
+// contiguous handles covering the array in at most parts slabs along its last dimension
+inline auto scatter(const shared_handle& h, size_t parts) {
+  auto extent = static_cast<size_t>(h.shape[h.dims - 1]);
+  parts = std::max<size_t>(1, std::min(parts, extent));
+
+  std::vector<shared_handle> slices;
+  slices.reserve(parts);
+  for (size_t i = 0; i < parts; ++i)
+    slices.push_back(h.slice(extent * i / parts, extent * (i + 1) / parts));
+  return slices;
+}
+
+// runs fn on every slab of the array across the workers, which write their results in place,
+// the data is gathered once every task has completed and fn results are returned in slab order
+template <typename Callable, typename T>
+auto gather(peer& p, Callable fn, shared_array<T>& array, size_t parts = 0) {
+  return sweep(p, fn, scatter(array.handle(), parts ? parts : p.alive()));
+}
+
 } // namespace ig
 
 #endif // IG_CORE_DISTRIBUTE_H
@@ -8,12 +8,15 @@
 
 namespace ig {
 
+static IG_TLS bool worker_ = false;
+
 job::job(size_t workers)
   : running_{true}
   , jobs_{0} {
 
   for (size_t i = 0; i < workers; ++i)
     workers_.emplace_back([this] {
+      worker_ = true;
       for (;;) {
         task task{};
         {
@@ -38,6 +41,19 @@ job::~job() {
   for (auto& worker : workers_) worker.join();
 }
 
+job& job::get() {
+  static auto shared = new job{};
+  return *shared;
+}
+
+bool job::worker() {
+  return worker_;
+}
+
+void job::forked() {
+  worker_ = true;
+}
+
 void job::wait() {
   std::unique_lock<decltype(mutex_)> lock{mutex_};
   wait_.wait(lock, [this] { return !jobs_; });
@@ -21,6 +21,14 @@ public:
 
   void wait();
   template <typename Callable, typename... Args> auto work(Callable&& fn, Args&&... args);
+  template <typename Fn> void parallel_for(size_t count, size_t grain, Fn&& fn, size_t threads = 0);
+
+  auto workers() const { return workers_.size(); }
+
+  static job& get();
+  static bool worker();
+  // the threads of the pool do not survive a fork, the child marks itself so that its loops run inline
+  static void forked();
 
   job(const job&) = delete;
   job& operator=(const job&) = delete;
@@ -52,6 +60,42 @@ auto job::work(Callable&& fn, Args&&... args) {
   return res;
 }
 
+// splits [0, count) in chunks of grain indices claimed dynamically by up to threads participants, 
+// fn(begin, end) runs on the workers and the calling thread, which also waits for completion
+// a call from a worker runs inline, so that nested loops never wait on their own pool
+template <typename Fn>
+void job::parallel_for(size_t count, size_t grain, Fn&& fn, size_t threads) {
+  grain = std::max<size_t>(grain, 1);
+  auto chunks = (count + grain - 1) / grain;
+  threads = std::min(threads ? threads : workers_.size() + 1, chunks);
+  if (threads <= 1 || worker()) {
+    if (count) fn(size_t(0), count);
+    return;
+  }
+
+  // a failing chunk stops the remaining ones from being claimed
+  std::atomic_size_t next{0};
+  auto run = [&]() {
+    try {
+      for (size_t c; (c = next++) < chunks;)
+        fn(c * grain, std::min(count, (c + 1) * grain));
+    } catch (...) { next = chunks; throw; }
+  };
+
+  std::vector< std::future<void> > helpers;
+  helpers.reserve(threads - 1);
+  for (size_t i = 0; i < threads - 1; ++i) helpers.push_back(work(run));
+
+  // every helper must be done with the shared state before leaving, the first failure is rethrown
+  std::exception_ptr failure;
+  try { run(); } 
+  catch (...) { failure = std::current_exception(); }
+  for (auto& h : helpers) {
+    try { h.get(); } 
+    catch (...) { if (!failure) failure = std::current_exception(); }
+  } if (failure) std::rethrow_exception(failure);
+}
+
 } // namespace ig
 
 #endif // IG_CORE_JOB_H
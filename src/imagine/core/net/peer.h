@@ -8,9 +8,96 @@
 #define IG_CORE_PEER_H
 
 #include "imagine/ig.h"
+#include "imagine/core/settings/serialize.h"
+
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace ig {
 
+// Multi-process job execution
+// workers are forked at construction and served over unix domain socket pairs
+// tasks are trivially copyable callables (function pointers, lambdas capturing values) shipped as bytes,
+// so they resolve to the same code in every worker, arguments and results go through byte streams
+// a worker that dies fails its pending futures and is removed from the rotation
+class IG_API peer {
+public:
+  explicit peer(size_t workers = std::thread::hardware_concurrency());
+  ~peer();
+
+  void wait();
+  template <typename Callable, typename... Args> auto work(Callable fn, Args&&... args);
+
+  auto workers() const { return workers_.size(); }
+  auto alive() const -> size_t;
+
+  peer(const peer&) = delete;
+  peer& operator=(const peer&) = delete;
+
+private:
+  using invoker    = void(*)(byte_reader&, byte_writer&);
+  using completion = std::function< void(byte_reader*, std::exception_ptr) >;
+
+  template <typename Callable, typename R, typename... Args>
+  static void invoke(byte_reader& in, byte_writer& out);
+
+  void submit(invoker fn, byte_writer&& args, completion&& done);
+  void receive();
+  void fail(size_t worker);
+
+  struct worker { int fd; int pid; bool alive; size_t pending; std::mutex send; };
+  struct task   { size_t worker; completion done; };
+
+  mutable std::mutex mutex_;
+  std::condition_variable idle_;
+  std::vector< std::unique_ptr<worker> > workers_;
+  std::unordered_map<uint64_t, task> tasks_;
+  uint64_t next_;
+  int wake_[2];
+  std::thread receiver_;
+};
+
+template <typename Callable, typename R, typename... Args>
+void peer::invoke(byte_reader& in, byte_writer& out) {
+  alignas(Callable) char raw[sizeof(Callable)];
+  in.read(raw, sizeof(Callable));
+  auto& fn = *reinterpret_cast<Callable*>(raw);
+
+  std::tuple<Args...> args;
+  std::apply([&in](auto&... a) { (in >> ... >> a); }, args);
+  if constexpr (std::is_void_v<R>) std::apply(fn, std::move(args));
+  else
+    out << std::apply(fn, std::move(args));
+}
+
+template <typename Callable, typename... Args>
+auto peer::work(Callable fn, Args&&... args) {
+  static_assert(std::is_trivially_copyable_v<Callable>, "Peer tasks must be trivially copyable callables");
+  using return_type = std::invoke_result_t<Callable, std::decay_t<Args>...>;
+
+  byte_writer w;
+  w.write(&fn, sizeof(Callable));
+  (w << ... << args);
+
+  auto promise = std::make_shared< std::promise<return_type> >();
+  auto res = promise->get_future();
+  submit(
+    &invoke<Callable, return_type, std::decay_t<Args>...>,
+    std::move(w),
+    [promise](byte_reader* r, std::exception_ptr e) {
+      if (e) promise->set_exception(e);
+      else if constexpr (std::is_void_v<return_type>) promise->set_value();
+      else {
+        return_type v{};
+        *r >> v;
+        promise->set_value(std::move(v));
+      }
+    });
+  return res;
+}
+
 } // namespace ig
 
 #endif // IG_CORE_PEER_H
@@ -0,0 +1,255 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/net/peer.h"
+#include "imagine/core/net/job.h"
+
+#include <algorithm>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ig {
+
+namespace {
+
+struct frame {
+  uint64_t id;
+  uint64_t fn;
+  uint64_t size;
+  uint64_t status;
+};
+
+bool send_all(int fd, const void* data, size_t size) {
+  auto p = static_cast<const char*>(data);
+  while (size) {
+    auto n = ::send(fd, p, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  } return true;
+}
+
+bool recv_all(int fd, void* data, size_t size) {
+  auto p = static_cast<char*>(data);
+  while (size) {
+    auto n = ::recv(fd, p, size, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  } return true;
+}
+
+// worker process loop, tasks resolve to the same addresses as in the parent image
+[[noreturn]] void serve(int fd) {
+  using invoker = void(*)(byte_reader&, byte_writer&);
+  job::forked();
+
+  std::vector<char> in;
+  for (;;) {
+    frame f{};
+    if (!recv_all(fd, &f, sizeof(f))) ::_exit(0);
+    in.resize(f.size);
+    if (!recv_all(fd, in.data(), in.size())) ::_exit(0);
+
+    byte_reader r{in.data(), in.size()};
+    byte_writer w;
+    uint64_t status = 0;
+    try {
+      reinterpret_cast<invoker>(f.fn)(r, w);
+    } catch (const std::exception& e) {
+      w = byte_writer{};
+      w << std::string{e.what()};
+      status = 1;
+    } catch (...) {
+      w = byte_writer{};
+      w << std::string{"unknown exception"};
+      status = 1;
+    }
+
+    frame o{f.id, 0, w.buffer().size(), status};
+    if (!send_all(fd, &o, sizeof(o)) ||
+        !send_all(fd, w.buffer().data(), w.buffer().size())) ::_exit(1);
+  }
+}
+
+} // namespace
+
+peer::peer(size_t workers)
+  : next_{0} {
+
+  // forked before any helper thread exists in this object
+  for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+      throw std::runtime_error{"[Peer] Unable to create worker channel"};
+
+    auto pid = ::fork();
+    if (pid < 0) throw std::runtime_error{"[Peer] Unable to spawn worker process"};
+    if (pid == 0) {
+      ::close(fds[0]);
+      for (auto& w : workers_) ::close(w->fd);
+      serve(fds[1]);
+    }
+
+    ::close(fds[1]);
+    auto w = std::make_unique<worker>();
+    w->fd = fds[0];
+    w->pid = pid;
+    w->alive = true;
+    w->pending = 0;
+    workers_.push_back(std::move(w));
+  }
+
+  if (::pipe(wake_) != 0) throw std::runtime_error{"[Peer] Unable to create wake channel"};
+  receiver_ = std::thread{[this] { receive(); }};
+}
+
+peer::~peer() {
+  for (auto& w : workers_) ::shutdown(w->fd, SHUT_WR);
+
+  char c = 0;
+  while (::write(wake_[1], &c, 1) < 0 && errno == EINTR) {}
+  receiver_.join();
+
+  for (auto& w : workers_) {
+    ::close(w->fd);
+    ::waitpid(w->pid, nullptr, 0);
+  }
+  ::close(wake_[0]);
+  ::close(wake_[1]);
+}
+
+auto peer::alive() const -> size_t {
+  std::lock_guard<decltype(mutex_)> lock{mutex_};
+  return std::count_if(workers_.begin(), workers_.end(), [](auto& w) { return w->alive; });
+}
+
+void peer::wait() {
+  std::unique_lock<decltype(mutex_)> lock{mutex_};
+  idle_.wait(lock, [this] { return tasks_.empty(); });
+}
+
+void peer::submit(invoker fn, byte_writer&& args, completion&& done) {
+  worker* w = nullptr;
+  uint64_t id;
+  size_t index = 0;
+  {
+    std::lock_guard<decltype(mutex_)> lock{mutex_};
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      auto& c = workers_[i];
+      if (c->alive && (!w || c->pending < w->pending)) {
+        w = c.get();
+        index = i;
+      }
+    }
+    if (!w) throw std::runtime_error{"[Peer] No worker process alive"};
+
+    id = next_++;
+    w->pending++;
+    tasks_.emplace(id, task{index, std::move(done)});
+  }
+
+  frame f{id, reinterpret_cast<uint64_t>(fn), args.buffer().size(), 0};
+  bool sent;
+  {
+    std::lock_guard<decltype(w->send)> lock{w->send};
+    sent = send_all(w->fd, &f, sizeof(f)) && send_all(w->fd, args.buffer().data(), args.buffer().size());
+  }
+  if (!sent) fail(index);
+}
+
+void peer::receive() {
+  std::vector<pollfd> fds;
+  std::vector<char> in;
+  bool stopping = false;
+  for (;;) {
+    fds.clear();
+    fds.push_back({stopping ? -1 : wake_[0], POLLIN, 0});
+    {
+      std::lock_guard<decltype(mutex_)> lock{mutex_};
+      for (auto& w : workers_) fds.push_back({w->alive ? w->fd : -1, POLLIN, 0});
+    }
+
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+
+    for (size_t i = 1; i < fds.size(); ++i) {
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+      frame f{};
+      auto worker = i - 1;
+      if (!recv_all(fds[i].fd, &f, sizeof(f)) || 
+          !(in.resize(f.size), recv_all(fds[i].fd, in.data(), in.size()))) {
+        fail(worker);
+        continue;
+      }
+
+      task t;
+      {
+        std::lock_guard<decltype(mutex_)> lock{mutex_};
+        auto it = tasks_.find(f.id);
+        if (it == tasks_.end()) continue;
+        t = std::move(it->second);
+        tasks_.erase(it);
+        workers_[worker]->pending--;
+      }
+
+      byte_reader r{in.data(), in.size()};
+      try {
+        if (f.status) {
+          std::string what;
+          r >> what;
+          throw std::runtime_error{what};
+        } t.done(&r, nullptr);
+      } catch (...) {
+        t.done(nullptr, std::current_exception());
+      }
+      idle_.notify_all();
+    }
+
+    // shutdown requested, drain what workers still owe
+    if (fds[0].revents & POLLIN) stopping = true;
+    if (stopping) {
+      std::lock_guard<decltype(mutex_)> lock{mutex_};
+      if (tasks_.empty() || std::none_of(workers_.begin(), workers_.end(), [](auto& w) { return w->alive; })) return;
+    }
+  }
+}
+
+void peer::fail(size_t index) {
+  std::vector<task> lost;
+  int pid;
+  {
+    std::lock_guard<decltype(mutex_)> lock{mutex_};
+    auto& w = *workers_[index];
+    if (!w.alive) return;
+    w.alive = false;
+    w.pending = 0;
+    pid = w.pid;
+    for (auto it = tasks_.begin(); it != tasks_.end();) {
+      if (it->second.worker == index) {
+        lost.push_back(std::move(it->second));
+        it = tasks_.erase(it);
+      } else ++it;
+    }
+  }
+
+  auto error = std::make_exception_ptr(
+    std::runtime_error{
+      "[Peer] Worker process " + std::to_string(pid) + 
+      " terminated before completing its tasks"});
+  for (auto& t : lost) t.done(nullptr, error);
+  idle_.notify_all();
+}
+
+} // namespace ig
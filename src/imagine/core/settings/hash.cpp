@@ -0,0 +1,201 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/settings/serialize.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ig {
+
+/*
+Short inputs follow the multiply-fold construction of wyhash (Wang Yi), long inputs
+accumulate 64-byte stripes in eight independent lanes as in XXH3 (Yann Collet)
+*/
+namespace {
+
+constexpr uint64_t s0 = 0xa0761d6478bd642full, s1 = 0xe7037ed1a0b428dbull, s2 = 0x8ebc6af09c88c6e3ull, s3 = 0x589965cc75374cc3ull;
+constexpr uint64_t p32 = 0x9e3779b1ull;
+constexpr uint64_t p64_1 = 0x9e3779b185ebca87ull, p64_2 = 0xc2b2ae3d27d4eb4full;
+
+constexpr size_t secret_size = 192;
+constexpr size_t stripe      = 64;
+constexpr size_t stripes     = (secret_size - stripe) / 8;
+constexpr size_t block       = stripe * stripes;
+
+constexpr auto make_secret() {
+  // splitmix64 sequence
+  std::array<uint64_t, secret_size / 8> s{};
+  uint64_t x = 0x2545f4914f6cdd1dull;
+  for (auto& v : s) {
+    auto z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    v = z ^ (z >> 31);
+  } return s;
+}
+
+alignas(64) constexpr auto secret = make_secret();
+
+inline uint64_t r8(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+inline uint64_t r4(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint64_t r3(const uint8_t* p, size_t k) { return (uint64_t(p[0]) << 16) | (uint64_t(p[k >> 1]) << 8) | p[k - 1]; }
+
+inline void mum(uint64_t& a, uint64_t& b) {
+  auto r = static_cast<__uint128_t>(a) * b;
+  a = static_cast<uint64_t>(r);
+  b = static_cast<uint64_t>(r >> 64);
+}
+inline uint64_t mix(uint64_t a, uint64_t b) { mum(a, b); return a ^ b; }
+
+inline uint64_t avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= 0x165667919e3779f9ull;
+  return h ^ (h >> 32);
+}
+
+// inputs up to the stripe threshold
+hash128 hash_short(const uint8_t* p, size_t len, uint64_t seed) {
+  seed ^= mix(seed ^ s0, s1);
+
+  uint64_t a, b;
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (r4(p) << 32) | r4(p + ((len >> 3) << 2));
+      b = (r4(p + len - 4) << 32) | r4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = r3(p, len);
+      b = 0;
+    } else a = b = 0;
+  } else {
+    auto i = len;
+    if (i > 48) {
+      auto see1 = seed, see2 = seed;
+      do {
+        seed = mix(r8(p)      ^ s1, r8(p + 8)  ^ seed);
+        see1 = mix(r8(p + 16) ^ s2, r8(p + 24) ^ see1);
+        see2 = mix(r8(p + 32) ^ s3, r8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = mix(r8(p) ^ s1, r8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = r8(p + i - 16);
+    b = r8(p + i - 8);
+  }
+
+  a ^= s1;
+  b ^= seed;
+  mum(a, b);
+  return {mix(a ^ s0 ^ len, b ^ s1), mix(b ^ s2 ^ len, a ^ s3)};
+}
+
+// stripe accumulation
+// acc[i] += lo32(d ^ k) * hi32(d ^ k) and acc[i ^ 1] += d, scrambled once per block
+// the accumulators are read as uint64_t elsewhere, vector paths go through loads and stores so that
+// they are not reordered around those reads
+inline void accumulate(uint64_t* acc, const uint8_t* p, const uint8_t* key) {
+#if defined(__AVX2__)
+  auto a = reinterpret_cast<__m256i*>(acc);
+  for (size_t i = 0; i < 2; ++i) {
+    auto dv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)   + i);
+    auto kv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i);
+    auto dk = _mm256_xor_si256(dv, kv);
+    auto pr = _mm256_mul_epu32(dk, _mm256_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1)));
+    auto sw = _mm256_shuffle_epi32(dv, _MM_SHUFFLE(1, 0, 3, 2));
+    _mm256_store_si256(a + i, _mm256_add_epi64(pr, _mm256_add_epi64(_mm256_load_si256(a + i), sw)));
+  }
+#elif defined(__SSE2__)
+  auto a = reinterpret_cast<__m128i*>(acc);
+  for (size_t i = 0; i < 4; ++i) {
+    auto dv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)   + i);
+    auto kv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + i);
+    auto dk = _mm_xor_si128(dv, kv);
+    auto pr = _mm_mul_epu32(dk, _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1)));
+    auto sw = _mm_shuffle_epi32(dv, _MM_SHUFFLE(1, 0, 3, 2));
+    _mm_store_si128(a + i, _mm_add_epi64(pr, _mm_add_epi64(_mm_load_si128(a + i), sw)));
+  }
+#else
+  for (size_t i = 0; i < 8; ++i) {
+    auto dv = r8(p + 8 * i);
+    auto dk = dv ^ r8(key + 8 * i);
+    acc[i ^ 1] += dv;
+    acc[i] += (dk & 0xffffffff) * (dk >> 32);
+  }
+#endif
+}
+
+inline void scramble(uint64_t* acc, const uint8_t* key) {
+  for (size_t i = 0; i < 8; ++i) {
+    auto a = acc[i];
+    a ^= a >> 47;
+    a ^= r8(key + 8 * i);
+    acc[i] = a * p32;
+  }
+}
+
+inline uint64_t merge(const uint64_t* acc, const uint8_t* key, uint64_t start) {
+  auto h = start;
+  for (size_t i = 0; i < 4; ++i)
+    h += mix(acc[2 * i] ^ r8(key + 16 * i), acc[2 * i + 1] ^ r8(key + 16 * i + 8));
+  return avalanche(h);
+}
+
+hash128 hash_long(const uint8_t* p, size_t len, uint64_t seed) {
+  alignas(64) uint64_t custom[secret_size / 8];
+  for (size_t i = 0; i < secret_size / 8; ++i)
+    custom[i] = secret[i] + (i & 1 ? -seed : seed);
+  auto key = reinterpret_cast<const uint8_t*>(custom);
+
+  alignas(32) uint64_t acc[8] = {p32, p64_1, p64_2, s0, s1, p64_2 ^ p32, s2, s3};
+
+  auto blocks = (len - 1) / block;
+  for (size_t b = 0; b < blocks; ++b, p += block) {
+    for (size_t s = 0; s < stripes; ++s)
+      accumulate(acc, p + s * stripe, key + s * 8);
+    scramble(acc, key + secret_size - stripe);
+  }
+
+  // partial block, then the final (overlapping) stripe
+  auto rest = len - blocks * block;
+  auto n = (rest - 1) / stripe;
+  for (size_t s = 0; s < n; ++s)
+    accumulate(acc, p + s * stripe, key + s * 8);
+  accumulate(acc, p + rest - stripe, key + secret_size - stripe - 7);
+
+  return {
+    merge(acc, key + 11, len * p64_1),
+    merge(acc, key + secret_size - stripe - 11, ~(len * p64_2))};
+}
+
+constexpr size_t long_threshold = 256;
+
+} // namespace
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+  auto p = static_cast<const uint8_t*>(data);
+  return size <= long_threshold
+    ? hash_short(p, size, seed).lo
+    : hash_long (p, size, seed).lo;
+}
+
+hash128 hash_bytes128(const void* data, size_t size, uint64_t seed) {
+  auto p = static_cast<const uint8_t*>(data);
+  return size <= long_threshold
+    ? hash_short(p, size, seed)
+    : hash_long (p, size, seed);
+}
+
+} // namespace ig
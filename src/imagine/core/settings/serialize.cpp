@@ -0,0 +1,122 @@
+/*
+ Imagine v0.1
+ [core]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "imagine/core/settings/serialize.h"
+#include "imagine/core/mem/mapping.h"
+
+#include <cstring>
+
+namespace ig {
+
+static constexpr char archive_magic[4] = {'I', 'G', 'B', 'A'};
+static constexpr uint32_t archive_order = 0x01020304;
+
+archive_writer::archive_writer(const std::string& path)
+  : os_{path, std::ios::binary | std::ios::trunc} {
+
+  if (!os_.good()) {
+    throw std::runtime_error{
+      "[Archive] Invalid output file " + path + 
+      " (inexistant, unavailable or inaccessible resource)"};
+  }
+
+  archive_header h{};
+  os_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+}
+
+// rank dimensions whose product (without overflow) is the element count
+bool archive_section::spans(size_t rank) const {
+  if (rank != dims || rank > archive_dims) return false;
+  if (std::find(shape, shape + rank, 0) != shape + rank) return count() == 0;
+
+  uint64_t n = 1;
+  for (size_t d = 0; d < rank; ++d) {
+    if (n > count() / shape[d]) return false;
+    n *= shape[d];
+  } return n == count();
+}
+
+archive_writer::~archive_writer() {
+  if (os_.is_open()) close();
+}
+
+size_t archive_writer::write(archive_section section, const void* data) {
+  static const char zeros[archive_align] = {};
+  auto pos = static_cast<uint64_t>(os_.tellp());
+  os_.write(zeros, (archive_align - pos % archive_align) % archive_align);
+
+  section.offset = static_cast<uint64_t>(os_.tellp());
+  os_.write(static_cast<const char*>(data), section.bytes);
+  if (!os_.good())
+    throw std::runtime_error{"[Archive] Failed to write section " + section.label()};
+
+  table_.push_back(section);
+  return table_.size() - 1;
+}
+
+void archive_writer::close() {
+  static const char zeros[archive_align] = {};
+  auto pos = static_cast<uint64_t>(os_.tellp());
+  os_.write(zeros, (archive_align - pos % archive_align) % archive_align);
+
+  archive_header h{};
+  std::memcpy(h.magic, archive_magic, sizeof(h.magic));
+  h.version = archive_version;
+  h.order   = archive_order;
+  h.count   = static_cast<uint32_t>(table_.size());
+  h.table   = static_cast<uint64_t>(os_.tellp());
+
+  os_.write(reinterpret_cast<const char*>(table_.data()), table_.size() * sizeof(archive_section));
+  os_.seekp(0);
+  os_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  os_.close();
+}
+
+archive::archive(const std::string& path)
+  : map_{std::make_shared<mapping>(path, mapping::mode::cow)}
+  , table_{nullptr}
+  , count_{0} {
+
+  archive_header h{};
+  if (map_->size() >= sizeof(h)) std::memcpy(&h, map_->data(), sizeof(h));
+
+  if (std::memcmp(h.magic, archive_magic, sizeof(h.magic)) || h.order != archive_order) {
+    throw std::runtime_error{
+      "[Archive] Invalid archive " + path + 
+      " (unrecognized signature or byte order)"};
+  }
+  if (h.version > archive_version) {
+    throw std::runtime_error{
+      "[Archive] Unsupported archive version " + std::to_string(h.version) + 
+      " in " + path};
+  }
+  // offsets and sizes come from the file, bounds are checked by differences so that they cannot wrap
+  auto size = static_cast<uint64_t>(map_->size());
+  if (h.table % alignof(archive_section) || h.table > size || h.count > (size - h.table) / sizeof(archive_section))
+    throw std::runtime_error{"[Archive] Truncated section table in " + path};
+
+  table_ = reinterpret_cast<const archive_section*>(map_->data() + h.table);
+  count_ = h.count;
+  for (size_t i = 0; i < count_; ++i) {
+    auto& s = table_[i];
+    if (s.offset % archive_align || s.offset > h.table || s.bytes > h.table - s.offset || !s.element)
+      throw std::runtime_error{"[Archive] Corrupted section " + std::to_string(i) + " in " + path};
+  }
+}
+
+auto archive::find(const std::string& name, section_kind kind) const -> size_t {
+  for (size_t i = 0; i < count_; ++i)
+    if (table_[i].kind == kind && !std::strncmp(table_[i].name, name.c_str(), sizeof(table_[i].name)))
+      return i;
+  return npos;
+}
+
+auto archive::payload(size_t i) const -> char* {
+  // private mapping, writes stay in copy-on-write pages
+  return map_->data() + table_[i].offset;
+}
+
+} // namespace ig
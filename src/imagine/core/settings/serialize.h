@@ -9,6 +9,11 @@
 
 #include "imagine/ig.h"
 
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
 namespace ig {
 
 template <typename T>
@@ -17,6 +22,243 @@ inline size_t hash_combine(size_t seed, const T& v) {
   return seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
 
+// Bulk hashing
+// non-cryptographic, stripe-parallel hash over raw bytes (vectorized with SSE2/AVX2 when available)
+// results are stable across runs and platforms of the same byte order
+struct hash128 {
+  uint64_t lo, hi;
+
+  bool operator==(const hash128& o) const { return lo == o.lo && hi == o.hi; }
+  bool operator!=(const hash128& o) const { return !(*this == o); }
+};
+
+IG_API uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+IG_API hash128  hash_bytes128(const void* data, size_t size, uint64_t seed = 0);
+
+// content fingerprint of a typed buffer with its shape, used for caching and deduplication
+template 
+< typename T, 
+  typename Shape >
+auto fingerprint(const T* data, size_t count, const Shape& shape) {
+  uint64_t meta[2] = {sizeof(T), shape.size()};
+  auto seed = hash_bytes(meta, sizeof(meta));
+  for (auto dim : shape) 
+    seed = hash_bytes(&dim, sizeof(dim), seed);
+  return hash_bytes128(data, count * sizeof(T), seed);
+}
+
+// Byte streams
+// flat encoding of trivially copyable values, strings and vectors, used to ship arguments and results
+class byte_writer {
+public:
+  template <typename T>
+  auto& operator<<(const T& v) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      write(&v, sizeof(T));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      *this << v.size();
+      write(v.data(), v.size());
+    } else {
+      static_assert(std::is_same_v<T, std::vector<typename T::value_type, typename T::allocator_type>>, "Unsupported type in byte stream");
+      *this << v.size();
+      for (auto& e : v) *this << e;
+    } return *this;
+  }
+
+  void write(const void* data, size_t size) {
+    auto p = static_cast<const char*>(data);
+    buffer_.insert(buffer_.end(), p, p + size);
+  }
+
+  auto& buffer() const { return buffer_; }
+  auto& buffer()       { return buffer_; }
+
+private:
+  std::vector<char> buffer_;
+};
+
+class byte_reader {
+public:
+  explicit byte_reader(const char* data, size_t size)
+    : cur_{data}
+    , end_{data + size} {}
+
+  template <typename T>
+  auto& operator>>(T& v) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      read(&v, sizeof(T));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      size_t n; *this >> n;
+      v.resize(n);
+      read(&v[0], n);
+    } else {
+      size_t n; *this >> n;
+      v.resize(n);
+      for (auto& e : v) *this >> e;
+    } return *this;
+  }
+
+  void read(void* data, size_t size) {
+    if (size > size_t(end_ - cur_))
+      throw std::runtime_error{"[Serialize] Truncated byte stream"};
+    std::copy(cur_, cur_ + size, static_cast<char*>(data));
+    cur_ += size;
+  }
+
+private:
+  const char* cur_;
+  const char* end_;
+};
+
+// Binary archive
+// versioned container of named, typed sections
+// layout -> header | payloads (each aligned on archive_align) | section table
+constexpr uint32_t archive_version = 1;
+constexpr size_t   archive_align   = 64;
+constexpr size_t   archive_dims    = 8;
+
+enum class section_kind : uint32_t { raw, ndarray, matrix, mesh_faces, mesh_vertices };
+enum class section_type : uint32_t { opaque, i8, u8, i16, u16, i32, u32, i64, u64, f32, f64, f16, bf16 };
+
+// element types outside of core name their own section type, e.g. float16
+template <typename T, typename = void> struct has_section_type : std::false_type {};
+template <typename T> struct has_section_type< T, std::void_t<decltype(T::section)> > : std::true_type {};
+
+template <typename T>
+constexpr auto section_type_of() {
+  using t = std::remove_cv_t<T>;
+  if constexpr (std::is_same_v<t, float>)    return section_type::f32;
+  else if constexpr (std::is_same_v<t, double>)   return section_type::f64;
+  else if constexpr (std::is_same_v<t, int8_t>)   return section_type::i8;
+  else if constexpr (std::is_same_v<t, uint8_t>)  return section_type::u8;
+  else if constexpr (std::is_same_v<t, int16_t>)  return section_type::i16;
+  else if constexpr (std::is_same_v<t, uint16_t>) return section_type::u16;
+  else if constexpr (std::is_same_v<t, int32_t>)  return section_type::i32;
+  else if constexpr (std::is_same_v<t, uint32_t>) return section_type::u32;
+  else if constexpr (std::is_same_v<t, int64_t>)  return section_type::i64;
+  else if constexpr (std::is_same_v<t, uint64_t>) return section_type::u64;
+  else if constexpr (has_section_type<t>::value)   return t::section;
+  else
+    return section_type::opaque;
+}
+
+struct archive_header {
+  char magic[4];
+  uint32_t version;
+  uint32_t order;
+  uint32_t count;
+  uint64_t table;
+  uint64_t reserved;
+};
+
+struct archive_section {
+  char name[32];
+  section_kind kind;
+  section_type type;
+  uint32_t element;
+  uint32_t dims;
+  uint64_t shape[archive_dims];
+  uint64_t offset;
+  uint64_t bytes;
+
+  auto count() const { return bytes / element; }
+
+  // the table comes from the file, names may fill their storage and shapes may not describe the payload
+  auto label() const { return std::string{name, std::find(name, name + sizeof(name), '\0')}; }
+  bool spans(size_t rank) const;
+};
+
+template <typename T>
+class section_view {
+public:
+  explicit section_view(T* data = nullptr, size_t size = 0)
+    : data_{data}
+    , size_{size} {}
+
+  auto begin() const { return data_; }
+  auto end() const   { return data_ + size_; }
+  auto data() const  { return data_; }
+  auto size() const  { return size_; }
+  auto& operator[](size_t n) const { return data_[n]; }
+
+private:
+  T* data_;
+  size_t size_;
+};
+
+class IG_API archive_writer {
+public:
+  explicit archive_writer(const std::string& path);
+  ~archive_writer();
+
+  template <typename T, typename Shape>
+  size_t write(const std::string& name, section_kind kind, const T* data, size_t count, const Shape& shape);
+  size_t write(archive_section section, const void* data);
+  void close();
+
+  archive_writer(const archive_writer&) = delete;
+  archive_writer& operator=(const archive_writer&) = delete;
+
+private:
+  std::ofstream os_;
+  std::vector<archive_section> table_;
+};
+
+class mapping;
+class IG_API archive {
+public:
+  static constexpr auto npos = size_t(-1);
+
+  explicit archive(const std::string& path);
+
+  auto size() const { return count_; }
+  auto find(const std::string& name, section_kind kind) const -> size_t;
+  auto& operator[](size_t i) const { return table_[i]; }
+
+  template <typename T> auto data(size_t i) const -> T*;
+  template <typename T> auto view(size_t i) const { return section_view<T>{data<T>(i), table_[i].count()}; }
+
+  auto holder() const -> std::shared_ptr<const void> { return map_; }
+
+private:
+  auto payload(size_t i) const -> char*;
+
+  std::shared_ptr<mapping> map_;
+  const archive_section* table_;
+  size_t count_;
+};
+
+template 
+< typename T, 
+  typename Shape >
+size_t archive_writer::write(const std::string& name, section_kind kind, const T* data, size_t count, const Shape& shape) {
+  archive_section s{};
+  if (name.size() >= sizeof(s.name) || shape.size() > archive_dims) {
+    throw std::invalid_argument{
+      "[Archive] Invalid section " + name + 
+      " (name or rank exceeds the format limits)"};
+  }
+
+  std::copy(name.begin(), name.end(), s.name);
+  std::copy(shape.begin(), shape.end(), s.shape);
+  s.kind    = kind;
+  s.type    = section_type_of<T>();
+  s.element = sizeof(T);
+  s.dims    = static_cast<uint32_t>(shape.size());
+  s.bytes   = count * sizeof(T);
+  return write(s, data);
+}
+
+template <typename T>
+auto archive::data(size_t i) const -> T* {
+  auto& s = table_[i];
+  if (s.element != sizeof(T) || (s.type != section_type::opaque && s.type != section_type_of<T>())) {
+    throw std::runtime_error{
+      "[Archive] Section " + s.label() + 
+      " does not hold the requested element type"};
+  } return reinterpret_cast<T*>(payload(i));
+}
+
 } // namespace ig
 
 #endif // IG_CORE_SERIALIZE_H
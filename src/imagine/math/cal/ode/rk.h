@@ -8,6 +8,7 @@
 #define IG_MATH_RK_H
 
 #include "imagine/math/basis.h"
+#include "imagine/core/mem/arena.h"
 
 namespace ig {
 
@@ -56,8 +57,15 @@ public:
     auto ev = 0;
     bool accept = false;
 
+    auto caller = memory_resource::current();
+    auto& scratch = arena::local();
     while (!accept) {
-      auto [ec, yn, fn] = rk_step(s, y, p.fs, dt, t);
+      // stage temporaries live in the thread arena for the duration of one attempt,
+      // the system is evaluated under the resource of the caller (see rk_step)
+      arena::frame frame{scratch};
+      resource_scope scope{scratch};
+
+      auto [ec, yn, fn] = rk_step(s, y, p.fs, dt, t, caller);
       auto en = *std::max_element(ec.begin(), ec.end(), [](auto lhs, auto rhs) { return std::abs(lhs) < std::abs(rhs); });
 
       auto norm = std::inner_product(
@@ -99,7 +107,14 @@ public:
     State&   y,
     State&   f,
     float dt,
-    float t) const {
+    float t,
+    memory_resource* caller = memory_resource::current()) const {
+
+    // states returned by the system, and anything it keeps, are allocated from caller
+    auto eval = [&](float tn, auto&& yn) {
+      resource_scope user{*caller};
+      return s.eval(tn, std::forward<decltype(yn)>(yn));
+    };
 
     auto& c = nodes;
     auto& a = runge_kutta_matrix;
@@ -107,7 +122,7 @@ public:
     std::array<State, Stages> K{f};
 
     for (size_t i = 1, j = 0; i < Stages; ++i) {
-      K[i] = s.eval(
+      K[i] = eval(
         t + dt * c[i - 1],
         y + dt * std::inner_product(
           a.begin() + j, 
@@ -123,7 +138,7 @@ public:
         e.begin() + Stages, 
         K.begin(), 
         State{}) * dt;
-    auto fn = s.eval(t + dt, yn);
+    auto fn = eval(t + dt, yn);
 
     auto err = 
       std::inner_product(
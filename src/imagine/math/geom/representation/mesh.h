@@ -8,6 +8,7 @@
 #define IG_MATH_MESH_H
 
 #include "imagine/math/geom/representation/analytic/triangle.h"
+#include "imagine/core/settings/serialize.h"
 
 #include <array>
 
@@ -24,6 +25,7 @@ public:
   template <typename Vertex = vertex> auto operator[](size_t i) const;
 
   auto center_of_mass() const;
+  auto fingerprint() const;
 
   std::vector<face>   faces;
   std::vector<vertex> vertices;
@@ -70,6 +72,12 @@ auto mesh<Manifold>::center_of_mass() const {
   } return c / w;
 }
 
+template <typename Manifold>
+auto mesh<Manifold>::fingerprint() const {
+  auto f = ig::fingerprint(faces.data(), faces.size(), std::array<size_t, 1>{faces.size()});
+  return ig::fingerprint(vertices.data(), vertices.size(), std::array<size_t, 2>{vertices.size(), f.lo ^ f.hi});
+}
+
 } // namespace ig
 
 #endif // IG_MATH_MESH_H
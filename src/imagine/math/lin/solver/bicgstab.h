@@ -8,6 +8,7 @@
 #define IG_MATH_BICGSTAB_H
 
 #include "imagine/math/lin/algebra.h"
+#include "imagine/core/mem/arena.h"
 
 namespace ig  {
 namespace lin {
@@ -22,6 +23,14 @@ void bicgstab(const matrix_base<Mat>& A, const matrix_base<Rhs>& b, matrix_base<
   using vector_type = typename Precond::vector_type;
 
   auto n = A.diag_size();
+  // iteration temporaries are served by the thread arena, rewound after every step, the preconditioner
+  // runs under the resource of the caller so that nothing it keeps is left in the arena
+  auto& caller = *memory_resource::current();
+  auto& scratch = arena::local();
+  arena::frame frame{scratch};
+  resource_scope scope{scratch};
+  auto precond = [&](const auto& v) { resource_scope user{caller}; return c.step(v); };
+
   vector_type r = b - A % x;
   vector_type rn = r;
 
@@ -33,6 +42,7 @@ void bicgstab(const matrix_base<Mat>& A, const matrix_base<Rhs>& b, matrix_base<
               y{n}, z{n}, s{n}, t{n};
 
   while (dot(r, r) > threshold) {
+    arena::frame iteration{scratch};
     auto nn = no;
     no = dot(rn, r);
 
@@ -45,11 +55,11 @@ void bicgstab(const matrix_base<Mat>& A, const matrix_base<Rhs>& b, matrix_base<
     auto q = (no / nn) * (a / w);
     p = r + q * (p - w * v);
 
-    y = c.step(p); 
+    y = precond(p); 
     v = A % y;
     a = no / dot(rn, v);
     s = r - a * v;
-    z = c.step(s); 
+    z = precond(s); 
     t = A % z;
 
     auto tt = dot(t, t);
@@ -8,6 +8,7 @@
 #define IG_MATH_CG_H
 
 #include "imagine/math/lin/algebra.h"
+#include "imagine/core/mem/arena.h"
 
 namespace ig  {
 namespace lin {
@@ -21,20 +22,29 @@ void cg(const matrix_base<Mat>& A, const matrix_base<Rhs>& b, matrix_base<Lhs>&
   using vector_type = typename Precond::vector_type;
 
   auto n = A.diag_size();
+  // iteration temporaries are served by the thread arena, rewound after every step, the preconditioner
+  // runs under the resource of the caller so that nothing it keeps is left in the arena
+  auto& caller = *memory_resource::current();
+  auto& scratch = arena::local();
+  arena::frame frame{scratch};
+  resource_scope scope{scratch};
+  auto precond = [&](const auto& v) { resource_scope user{caller}; return c.step(v); };
+
   vector_type r = b - A % x;
 
   auto threshold = tolerance * tolerance * dot(b, b);
-  auto p = c.step(r);
+  auto p = precond(r);
   auto ro = dot(r, p), no = dot(r, r);
 
   vector_type z{n}, v{n};
   while (dot(r, r) > threshold) {
+    arena::frame iteration{scratch};
     v = A % p;
     auto a = ro / dot(p, v);
     x += a * p;
     r -= a * v;
 
-    z = c.step(r);
+    z = precond(r);
 
     auto rn = ro;
     ro = dot(r, z);
@@ -0,0 +1,378 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_GEMM_H
+#define IG_MATH_GEMM_H
+
+#include "imagine/math/basis.h"
+#include "imagine/math/theory/simd_accel/intrinsics.h"
+#include "imagine/core/mem/pages.h"
+#include "imagine/core/net/job.h"
+
+#include <vector>
+
+namespace ig {
+
+// Register lanes
+// vectors of width elements used by the micro-kernels, a tile of rows x (cols * width) elements of the product
+// is accumulated in rows * cols registers, scalar lanes for other types
+template <typename T>
+struct gemm_lanes {
+  using type = T;
+  static constexpr size_t width = 1, rows = 4, cols = 4;
+  static auto zero()               { return T(0); }
+  static auto broadcast(T v)       { return v; }
+  static auto load(const T* src)   { return *src; }
+  static void store(T* dst, T v)   { *dst = v; }
+  static auto add(T a, T b)        { return a + b; }
+  static auto fma(T a, T b, T acc) { return acc + a * b; }
+};
+
+#if defined(IG_X86) && defined(IG_AVX512)
+template <>
+struct gemm_lanes<float> {
+  using type = __m512;
+  static constexpr size_t width = 16, rows = 6, cols = 2;
+  static auto zero()                        { return _mm512_setzero_ps(); }
+  static auto broadcast(float v)            { return _mm512_set1_ps(v); }
+  static auto load(const float* src)        { return _mm512_loadu_ps(src); }
+  static void store(float* dst, type v)     { _mm512_storeu_ps(dst, v); }
+  static auto add(type a, type b)           { return _mm512_add_ps(a, b); }
+  static auto fma(type a, type b, type acc) { return _mm512_fmadd_ps(a, b, acc); }
+};
+
+template <>
+struct gemm_lanes<double> {
+  using type = __m512d;
+  static constexpr size_t width = 8, rows = 6, cols = 2;
+  static auto zero()                        { return _mm512_setzero_pd(); }
+  static auto broadcast(double v)           { return _mm512_set1_pd(v); }
+  static auto load(const double* src)       { return _mm512_loadu_pd(src); }
+  static void store(double* dst, type v)    { _mm512_storeu_pd(dst, v); }
+  static auto add(type a, type b)           { return _mm512_add_pd(a, b); }
+  static auto fma(type a, type b, type acc) { return _mm512_fmadd_pd(a, b, acc); }
+};
+#elif defined(IG_X86) && defined(IG_AVX)
+template <>
+struct gemm_lanes<float> {
+  using type = __m256;
+  static constexpr size_t width = 8, rows = 6, cols = 2;
+  static auto zero()                        { return _mm256_setzero_ps(); }
+  static auto broadcast(float v)            { return _mm256_set1_ps(v); }
+  static auto load(const float* src)        { return _mm256_loadu_ps(src); }
+  static void store(float* dst, type v)     { _mm256_storeu_ps(dst, v); }
+  static auto add(type a, type b)           { return _mm256_add_ps(a, b); }
+# if defined(IG_FMA)
+  static auto fma(type a, type b, type acc) { return _mm256_fmadd_ps(a, b, acc); }
+# else
+  static auto fma(type a, type b, type acc) { return _mm256_add_ps(acc, _mm256_mul_ps(a, b)); }
+# endif
+};
+
+template <>
+struct gemm_lanes<double> {
+  using type = __m256d;
+  static constexpr size_t width = 4, rows = 6, cols = 2;
+  static auto zero()                        { return _mm256_setzero_pd(); }
+  static auto broadcast(double v)           { return _mm256_set1_pd(v); }
+  static auto load(const double* src)       { return _mm256_loadu_pd(src); }
+  static void store(double* dst, type v)    { _mm256_storeu_pd(dst, v); }
+  static auto add(type a, type b)           { return _mm256_add_pd(a, b); }
+# if defined(IG_FMA)
+  static auto fma(type a, type b, type acc) { return _mm256_fmadd_pd(a, b, acc); }
+# else
+  static auto fma(type a, type b, type acc) { return _mm256_add_pd(acc, _mm256_mul_pd(a, b)); }
+# endif
+};
+#elif defined(IG_X86) && defined(IG_SSE)
+template <>
+struct gemm_lanes<float> {
+  using type = __m128;
+  static constexpr size_t width = 4, rows = 6, cols = 2;
+  static auto zero()                        { return _mm_setzero_ps(); }
+  static auto broadcast(float v)            { return _mm_set1_ps(v); }
+  static auto load(const float* src)        { return _mm_loadu_ps(src); }
+  static void store(float* dst, type v)     { _mm_storeu_ps(dst, v); }
+  static auto add(type a, type b)           { return _mm_add_ps(a, b); }
+  static auto fma(type a, type b, type acc) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+};
+
+template <>
+struct gemm_lanes<double> {
+  using type = __m128d;
+  static constexpr size_t width = 2, rows = 6, cols = 2;
+  static auto zero()                        { return _mm_setzero_pd(); }
+  static auto broadcast(double v)           { return _mm_set1_pd(v); }
+  static auto load(const double* src)       { return _mm_loadu_pd(src); }
+  static void store(double* dst, type v)    { _mm_storeu_pd(dst, v); }
+  static auto add(type a, type b)           { return _mm_add_pd(a, b); }
+  static auto fma(type a, type b, type acc) { return _mm_add_pd(acc, _mm_mul_pd(a, b)); }
+};
+#endif
+
+// Micro-kernel
+// c[mr x nr] (stride ldc) += a * b over a depth of k, a packed by columns of mr elements and b by rows of nr,
+// the tile stays in registers for the whole depth, rows and columns of registers are unrolled so that none is spilled
+template <typename T>
+struct gemm_kernel {
+  using lanes = gemm_lanes<T>;
+  using packet = typename lanes::type;
+  static constexpr size_t width = lanes::width, mr = lanes::rows, nr = lanes::cols * lanes::width;
+
+  using rows = std::make_index_sequence<mr>;
+  using cols = std::make_index_sequence<lanes::cols>;
+
+  static void tile(size_t k, const T* a, const T* b, T* c, size_t ldc) {
+    packet acc[mr][lanes::cols];
+    zero(acc, rows{});
+    for (size_t p = 0; p < k; ++p, a += mr, b += nr) {
+      packet bv[lanes::cols];
+      load(bv, b, cols{});
+      step(acc, a, bv, rows{});
+    }
+    store(acc, c, ldc, rows{});
+  }
+
+  // tiles cut by the edges of the product are accumulated aside
+  static void edge(size_t k, const T* a, const T* b, T* c, size_t ldc, size_t m, size_t n) {
+    T tmp[mr * nr] = {};
+    tile(k, a, b, tmp, nr);
+    for (size_t i = 0; i < m; ++i)
+      for (size_t j = 0; j < n; ++j) c[i * ldc + j] += tmp[i * nr + j];
+  }
+
+private:
+  template <size_t... J> static void clear(packet* v, std::index_sequence<J...>) 
+  { ((v[J] = lanes::zero()), ...); }
+  template <size_t... J> static void load(packet* v, const T* src, std::index_sequence<J...>) 
+  { ((v[J] = lanes::load(src + J * width)), ...); }
+  template <size_t... J> static void fma(packet* acc, packet a, const packet* b, std::index_sequence<J...>) 
+  { ((acc[J] = lanes::fma(a, b[J], acc[J])), ...); }
+  template <size_t... J> static void add(const packet* acc, T* dst, std::index_sequence<J...>) 
+  { (lanes::store(dst + J * width, lanes::add(lanes::load(dst + J * width), acc[J])), ...); }
+
+  template <size_t... I> static void zero(packet (&acc)[mr][lanes::cols], std::index_sequence<I...>) 
+  { (clear(acc[I], cols{}), ...); }
+  template <size_t... I> static void step(packet (&acc)[mr][lanes::cols], const T* a, const packet* b, std::index_sequence<I...>) 
+  { (fma(acc[I], lanes::broadcast(a[I]), b, cols{}), ...); }
+  template <size_t... I> static void store(const packet (&acc)[mr][lanes::cols], T* c, size_t ldc, std::index_sequence<I...>) 
+  { (add(acc[I], c + I * ldc, cols{}), ...); }
+};
+
+// Blocking
+// depth kc of the packed panels keeps a micro-panel of a and b in L1, mc rows of a packed block stay in L2
+// and nc columns of a packed panel of b in L3
+template <typename T>
+struct gemm_blocking {
+  using kernel = gemm_kernel<T>;
+  static constexpr size_t kc = std::max<size_t>(64, (32 << 10) / ((kernel::mr + kernel::nr) * sizeof(T)) / 8 * 8);
+  static constexpr size_t mc = std::max<size_t>(1, (256 << 10) / (kc * sizeof(T)) / kernel::mr) * kernel::mr;
+  static constexpr size_t nc = std::max<size_t>(1, (4 << 20) / (kc * sizeof(T)) / kernel::nr) * kernel::nr;
+};
+
+// Operands
+// element (i, j) of a matrix operand is read at data[i * rs + j * cs], transposes swap the strides
+template <typename S>
+struct gemm_operand {
+  const S* data;
+  size_t rs, cs;
+
+  auto at(size_t i, size_t j) const { return data + i * rs + j * cs; }
+  auto t() const { return gemm_operand{data, cs, rs}; }
+};
+
+// Packing
+// rows [i, i + m) and depth [p, p + k) of alpha * a, by panels of mr rows stored column after column,
+// the rows past m are padded with zeros
+template
+< typename T,
+  typename S >
+void gemm_pack_lhs(T* dst, const gemm_operand<S>& a, size_t i, size_t m, size_t p, size_t k, T alpha) {
+  constexpr auto mr = gemm_kernel<T>::mr;
+  for (size_t ir = 0; ir < m; ir += mr) {
+    auto rows = std::min(mr, m - ir);
+    for (size_t q = 0; q < k; ++q, dst += mr) {
+      auto src = a.at(i + ir, p + q);
+      size_t r = 0;
+      for (; r < rows; ++r) dst[r] = alpha * T(src[r * a.rs]);
+      for (; r < mr; ++r)   dst[r] = T(0);
+    }
+  }
+}
+
+// depth [p, p + k) and columns [j, j + n) of b, by panels of nr columns stored row after row,
+// the columns past n are padded with zeros
+template
+< typename T,
+  typename S >
+void gemm_pack_rhs(T* dst, const gemm_operand<S>& b, size_t p, size_t k, size_t j, size_t n) {
+  constexpr auto nr = gemm_kernel<T>::nr;
+  for (size_t jr = 0; jr < n; jr += nr) {
+    auto cols = std::min(nr, n - jr);
+    for (size_t q = 0; q < k; ++q, dst += nr) {
+      auto src = b.at(p + q, j + jr);
+      size_t c = 0;
+      if (b.cs == 1)
+        for (; c < cols; ++c) dst[c] = T(src[c]);
+      else
+        for (; c < cols; ++c) dst[c] = T(src[c * b.cs]);
+      for (; c < nr; ++c) dst[c] = T(0);
+    }
+  }
+}
+
+// packed panels of the calling thread, kept between products, blocks of a (Side = 0) and panels of b (Side = 1)
+// are held apart as the panels of b are shared with the other threads of a product, sized by the products
+// themselves so that small ones do not hold full cache blocks
+template 
+< typename T, 
+  size_t Side >
+auto gemm_panel(size_t n) -> T* {
+  thread_local std::vector<T, aligned_allocator<T, 64, transparent_pages>> panel;
+  if (panel.size() < n) panel.resize(n);
+  return panel.data();
+}
+
+// mb x nb block of c += packed a * packed b over a depth of kb, tile by tile
+template <typename T>
+void gemm_macro(T* c, size_t ldc, const T* a, const T* b, size_t mb, size_t nb, size_t kb) {
+  using kernel = gemm_kernel<T>;
+  constexpr auto mr = kernel::mr, nr = kernel::nr;
+
+  for (size_t jr = 0; jr < nb; jr += nr)
+    for (size_t ir = 0; ir < mb; ir += mr) {
+      auto pa = a + ir * kb;
+      auto pb = b + jr * kb;
+      auto pc = c + ir * ldc + jr;
+      if (ir + mr <= mb && jr + nr <= nb) kernel::tile(kb, pa, pb, pc, ldc);
+      else
+        kernel::edge(kb, pa, pb, pc, ldc, std::min(mr, mb - ir), std::min(nr, nb - jr));
+    }
+}
+
+// c = beta * c over an m x n block (stride ldc), cleared when beta is zero so that the previous content,
+// NaNs included, is not read
+template <typename T>
+void gemm_scale(T* c, size_t ldc, size_t m, size_t n, T beta) {
+  if (beta == T(1)) return;
+  for (size_t i = 0; i < m; ++i, c += ldc) {
+    if (beta == T(0)) std::fill_n(c, n, T(0));
+    else 
+      for (size_t j = 0; j < n; ++j) c[j] *= beta;
+  }
+}
+
+// products of at least gemm_parallel multiply-adds are worth spreading over the workers of job::get()
+constexpr size_t gemm_parallel = size_t(1) << 21;
+
+template
+< typename T,
+  typename SA,
+  typename SB >
+void gemm_depth_split(T* c, size_t ldc, const gemm_operand<SA>& a, const gemm_operand<SB>& b, size_t m, size_t n, size_t k, T alpha, size_t parts);
+
+// c (m x n, stride ldc) += alpha * a (m x k) * b (k x n), blocks of b are packed once per depth panel and blocks
+// of a, scaled by alpha, once per row block, elements of other types are converted to T while packing
+// with threads != 1 (0 for every worker), each panel of b is packed and shared by all participants, which
+// take blocks of rows and, when rows are too few, groups of columns, products of a long depth into a small
+// c are split along the depth instead
+template
+< typename T,
+  typename SA,
+  typename SB >
+void gemm_into(T* c, size_t ldc, const gemm_operand<SA>& a, const gemm_operand<SB>& b, size_t m, size_t n, size_t k, T alpha = T(1), size_t threads = 1) {
+  using blocking = gemm_blocking<T>;
+  constexpr auto mr = gemm_kernel<T>::mr, nr = gemm_kernel<T>::nr;
+  constexpr auto kc = blocking::kc, mc = blocking::mc, nc = blocking::nc;
+
+  if (!m || !n || !k) return;
+  if (!threads) threads = job::get().workers() + 1;
+
+  auto tiles = ((m + mr - 1) / mr) * ((n + nr - 1) / nr);
+  if (threads > 1 && tiles < threads && k >= 2 * kc)
+    return gemm_depth_split(c, ldc, a, b, m, n, k, alpha, std::min(threads, k / kc));
+
+  auto spread = [threads](size_t count, size_t grain, auto&& fn) {
+    if (threads == 1) fn(size_t(0), count);
+    else 
+      job::get().parallel_for(count, grain, fn, threads);
+  };
+
+  // row blocks of at most mc rows spread over the participants, then column groups of whole panels
+  auto mb = std::min(mc, std::max(mr, ((m + threads - 1) / threads + mr - 1) / mr * mr));
+  auto blocks = (m + mb - 1) / mb;
+  auto groups = std::max<size_t>(1, threads / blocks);
+
+  for (size_t jc = 0; jc < n; jc += nc) {
+    auto nb = std::min(nc, n - jc);
+    auto panels = (nb + nr - 1) / nr;
+    auto ng = (panels + groups - 1) / groups * nr;
+    auto units = blocks * ((nb + ng - 1) / ng);
+
+    for (size_t pc = 0; pc < k; pc += kc) {
+      auto kb = std::min(kc, k - pc);
+      auto pb = gemm_panel<T, 1>(kb * panels * nr);
+
+      spread(
+        panels,
+        (panels + threads - 1) / threads,
+        [&](size_t begin, size_t end) { 
+          gemm_pack_rhs(pb + begin * nr * kb, b, pc, kb, jc + begin * nr, std::min(nb, end * nr) - begin * nr); 
+        });
+
+      spread(
+        units,
+        1,
+        [&](size_t begin, size_t end) {
+          auto pa = gemm_panel<T, 0>(kb * mb);
+          for (auto u = begin; u < end; ++u) {
+            auto ic = u % blocks * mb, jg = u / blocks * ng;
+            auto rows = std::min(mb, m - ic);
+            gemm_pack_lhs(pa, a, ic, rows, pc, kb, alpha);
+            gemm_macro(c + ic * ldc + jc + jg, ldc, pa, pb + jg * kb, rows, std::min(ng, nb - jg), kb);
+          }
+        });
+    }
+  }
+}
+
+// depth split in parts of whole kc panels, the first part accumulates in c and the others in partial
+// products summed into c once all parts are done
+template
+< typename T,
+  typename SA,
+  typename SB >
+void gemm_depth_split(T* c, size_t ldc, const gemm_operand<SA>& a, const gemm_operand<SB>& b, size_t m, size_t n, size_t k, T alpha, size_t parts) {
+  constexpr auto kc = gemm_blocking<T>::kc;
+  auto depth = (k / kc + parts - 1) / parts * kc;
+  parts = (k + depth - 1) / depth;
+
+  std::vector<T> partial((parts - 1) * m * n, T(0));
+  job::get().parallel_for(
+    parts,
+    1,
+    [&](size_t begin, size_t end) {
+      for (auto part = begin; part < end; ++part) {
+        auto p = part * depth;
+        auto dst = part ? partial.data() + (part - 1) * m * n : c;
+        gemm_into(
+          dst, part ? n : ldc, 
+          gemm_operand<SA>{a.at(0, p), a.rs, a.cs}, 
+          gemm_operand<SB>{b.at(p, 0), b.rs, b.cs}, m, n, std::min(depth, k - p), alpha);
+      }
+    },
+    parts);
+
+  for (size_t part = 1; part < parts; ++part)
+    for (size_t i = 0; i < m; ++i) {
+      auto src = partial.data() + ((part - 1) * m + i) * n;
+      for (size_t j = 0; j < n; ++j) c[i * ldc + j] += src[j];
+    }
+}
+
+} // namespace ig
+
+#endif // IG_MATH_GEMM_H
@@ -0,0 +1,161 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_GEMV_H
+#define IG_MATH_GEMV_H
+
+#include "imagine/math/theory/detail/gemm.h"
+
+namespace ig {
+
+// Matrix-vector kernels
+// every element of the matrix is read once and used once, so that products run at the bandwidth of the memory,
+// rows stored contiguously are reduced against x (dot form) and contiguous columns scaled into y (axpy form),
+// both read the matrix in storage order, in register lanes (see gemm_lanes)
+template <typename T>
+struct gemv_kernel {
+  using lanes = gemm_lanes<T>;
+  using packet = typename lanes::type;
+  static constexpr size_t width = lanes::width, group = 4;
+
+  using lines = std::make_index_sequence<group>;
+
+  // y[i * incy] += alpha * (row i of a) . x for rows [0, m), a group of rows shares the loads of x
+  static void dot(T* y, size_t incy, const T* a, size_t lda, const T* x, size_t m, size_t n, T alpha) {
+    auto body = n / width * width;
+    size_t i = 0;
+    for (; i + group <= m; i += group, a += group * lda) {
+      packet acc[group];
+      clear(acc, lines{});
+      for (size_t j = 0; j < body; j += width)
+        dot_step(acc, a + j, lda, lanes::load(x + j), lines{});
+      dot_store(acc, y + i * incy, incy, a, lda, x, body, n, alpha, lines{});
+    }
+
+    for (; i < m; ++i, a += lda) {
+      auto acc = lanes::zero();
+      for (size_t j = 0; j < body; j += width) acc = lanes::fma(lanes::load(a + j), lanes::load(x + j), acc);
+      y[i * incy] += alpha * finish(acc, a, x, body, n);
+    }
+  }
+
+  // y[0, m) += alpha * sum of x[j * incx] * (column j of a), a group of columns is added per pass on y,
+  // rows are taken by chunks which stay in L1 across the columns
+  static void axpy(T* y, const T* a, size_t lda, const T* x, size_t incx, size_t m, size_t n, T alpha) {
+    constexpr size_t chunk = std::max<size_t>(width, (8 << 10) / sizeof(T) / width * width);
+    for (size_t i = 0; i < m; i += chunk) {
+      auto rows = std::min(chunk, m - i);
+      auto body = rows / width * width;
+      size_t j = 0;
+      for (; j + group <= n; j += group) {
+        packet xv[group];
+        T xs[group];
+        axpy_scale(xv, xs, x + j * incx, incx, alpha, lines{});
+        auto col = a + j * lda + i;
+        for (size_t r = 0; r < body; r += width)
+          lanes::store(y + i + r, axpy_step(lanes::load(y + i + r), col + r, lda, xv, lines{}));
+        for (size_t r = body; r < rows; ++r)
+          y[i + r] += axpy_tail(col + r, lda, xs, lines{});
+      }
+
+      for (; j < n; ++j) {
+        auto xs = alpha * x[j * incx];
+        auto xv = lanes::broadcast(xs);
+        auto col = a + j * lda + i;
+        for (size_t r = 0; r < body; r += width) lanes::store(y + i + r, lanes::fma(lanes::load(col + r), xv, lanes::load(y + i + r)));
+        for (size_t r = body; r < rows; ++r)     y[i + r] += xs * col[r];
+      }
+    }
+  }
+
+private:
+  static auto finish(packet acc, const T* a, const T* x, size_t body, size_t n) {
+    T lane[width];
+    lanes::store(lane, acc);
+    T s = 0;
+    for (size_t l = 0; l < width; ++l) s += lane[l];
+    for (size_t j = body; j < n; ++j) s += a[j] * x[j];
+    return s;
+  }
+
+  template <size_t... I> static void clear(packet* acc, std::index_sequence<I...>)
+  { ((acc[I] = lanes::zero()), ...); }
+  template <size_t... I> static void dot_step(packet* acc, const T* a, size_t lda, packet xv, std::index_sequence<I...>)
+  { ((acc[I] = lanes::fma(lanes::load(a + I * lda), xv, acc[I])), ...); }
+  template <size_t... I> static void dot_store(const packet* acc, T* y, size_t incy, const T* a, size_t lda, const T* x, size_t body, size_t n, T alpha, std::index_sequence<I...>)
+  { ((y[I * incy] += alpha * finish(acc[I], a + I * lda, x, body, n)), ...); }
+
+  template <size_t... J> static void axpy_scale(packet* xv, T* xs, const T* x, size_t incx, T alpha, std::index_sequence<J...>)
+  { ((xs[J] = alpha * x[J * incx], xv[J] = lanes::broadcast(xs[J])), ...); }
+  template <size_t... J> static auto axpy_step(packet acc, const T* col, size_t lda, const packet* xv, std::index_sequence<J...>)
+  { ((acc = lanes::fma(lanes::load(col + J * lda), xv[J], acc)), ...); return acc; }
+  template <size_t... J> static auto axpy_tail(const T* col, size_t lda, const T* xs, std::index_sequence<J...>)
+  { return ((xs[J] * col[J * lda]) + ...); }
+};
+
+// products of at least gemv_parallel elements of the matrix are spread over the workers of job::get(),
+// which take blocks of rows of y
+constexpr size_t gemv_parallel = size_t(1) << 18;
+
+// y (m elements, stride incy) += alpha * a (m x n) * x (n elements, x.at(j, 0)), the rows or the columns of a
+// are read in place when contiguous, x is gathered (and converted to T) when strided, y when the columns are,
+// matrices of other element types or of no contiguous dimension go through scalar loops
+template
+< typename T,
+  typename SA,
+  typename SX >
+void gemv_into(T* y, size_t incy, const gemm_operand<SA>& a, const gemm_operand<SX>& x, size_t m, size_t n, T alpha = T(1), size_t threads = 1) {
+  using kernel = gemv_kernel<T>;
+  if (!m || !n) return;
+  if (!threads) threads = job::get().workers() + 1;
+
+  auto spread = [threads, m](auto&& fn) {
+    if (threads == 1) fn(size_t(0), m);
+    else
+      job::get().parallel_for(m, std::max<size_t>(64, (m + threads - 1) / threads), fn, threads);
+  };
+
+  if constexpr (std::is_same_v<SA, T>) {
+    if (a.cs == 1) {
+      auto xv = reinterpret_cast<const T*>(x.data);
+      if (!std::is_same_v<SX, T> || x.rs != 1) {
+        auto packed = gemm_panel<T, 2>(n);
+        for (size_t j = 0; j < n; ++j) packed[j] = T(*x.at(j, 0));
+        xv = packed;
+      }
+      return spread([&](size_t begin, size_t end) { kernel::dot(y + begin * incy, incy, a.at(begin, 0), a.rs, xv, end - begin, n, alpha); });
+    }
+
+    if (a.rs == 1) {
+      auto xv = reinterpret_cast<const T*>(x.data);
+      auto incx = x.rs;
+      if (!std::is_same_v<SX, T>) {
+        auto packed = gemm_panel<T, 2>(n);
+        for (size_t j = 0; j < n; ++j) packed[j] = T(*x.at(j, 0));
+        xv = packed, incx = 1;
+      }
+
+      auto yv = y;
+      if (incy != 1) std::fill_n(yv = gemm_panel<T, 3>(m), m, T(0));
+      spread([&](size_t begin, size_t end) { kernel::axpy(yv + begin, a.at(begin, 0), a.cs, xv, incx, end - begin, n, alpha); });
+      if (incy != 1)
+        for (size_t i = 0; i < m; ++i) y[i * incy] += yv[i];
+      return;
+    }
+  }
+
+  spread([&](size_t begin, size_t end) {
+    for (auto i = begin; i < end; ++i) {
+      T s = 0;
+      for (size_t j = 0; j < n; ++j) s += T(*a.at(i, j)) * T(*x.at(j, 0));
+      y[i * incy] += alpha * s;
+    }
+  });
+}
+
+} // namespace ig
+
+#endif // IG_MATH_GEMV_H
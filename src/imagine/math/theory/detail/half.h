@@ -0,0 +1,193 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_HALF_H
+#define IG_MATH_HALF_H
+
+#include "imagine/math/basis.h"
+#include "imagine/math/theory/simd_accel/intrinsics.h"
+#include "imagine/core/settings/serialize.h"
+
+#include <cstring>
+
+namespace ig {
+
+// Half precision
+// 16-bit storage types read as float and rounded to nearest even when written, arithmetic on them
+// runs in float (float16 + float16 is a float), see widened_t
+namespace detail {
+
+inline auto float_bits(float v) { uint32_t u; std::memcpy(&u, &v, sizeof(u)); return u; }
+inline auto bits_float(uint32_t u) { float v; std::memcpy(&v, &u, sizeof(v)); return v; }
+
+// IEEE 754 binary16, 5 exponent and 10 mantissa bits, subnormals kept and NaNs made quiet
+inline uint16_t float_to_half(float v) {
+#if defined(IG_F16C)
+  return static_cast<uint16_t>(_cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT));
+#else
+  auto u = float_bits(v);
+  auto sign = (u >> 16) & 0x8000u;
+  u &= 0x7fffffffu;
+
+  if (u >= 0x47800000u) return static_cast<uint16_t>(sign | (u > 0x7f800000u ? 0x7e00u : 0x7c00u));
+  if (u < 0x38800000u) return static_cast<uint16_t>(sign | (float_bits(bits_float(u) + 0.5f) - 0x3f000000u));
+  u += 0xc8000fffu + ((u >> 13) & 1);
+  return static_cast<uint16_t>(sign | (u >> 13));
+#endif
+}
+
+inline float half_to_float(uint16_t h) {
+#if defined(IG_F16C)
+  return _cvtsh_ss(h);
+#else
+  auto u = uint32_t(h & 0x7fffu) << 13;
+  auto exp = u & 0x0f800000u;
+  u += 0x38000000u;
+  if (exp == 0x0f800000u) u += 0x38000000u;
+  else if (exp == 0) u = float_bits(bits_float(u + 0x00800000u) - bits_float(0x38800000u));
+  return bits_float(u | uint32_t(h & 0x8000u) << 16);
+#endif
+}
+
+// bfloat16, the upper half of a float
+inline uint16_t float_to_bfloat(float v) {
+  auto u = float_bits(v);
+  if ((u & 0x7fffffffu) > 0x7f800000u) return static_cast<uint16_t>((u >> 16) | 0x40u);
+  return static_cast<uint16_t>((u + 0x7fffu + ((u >> 16) & 1)) >> 16);
+}
+
+inline float bfloat_to_float(uint16_t h) { return bits_float(uint32_t(h) << 16); }
+
+} // namespace detail
+
+class bfloat16;
+
+class float16 {
+public:
+  static constexpr auto section = section_type::f16;
+
+  float16() = default;
+  float16(float v) : bits_{detail::float_to_half(v)} {}
+  float16(bfloat16 v);
+
+  operator float() const { return detail::half_to_float(bits_); }
+
+  auto& operator+=(float v) { return *this = float(*this) + v; }
+  auto& operator-=(float v) { return *this = float(*this) - v; }
+  auto& operator*=(float v) { return *this = float(*this) * v; }
+  auto& operator/=(float v) { return *this = float(*this) / v; }
+
+  auto bits() const { return bits_; }
+  static auto from_bits(uint16_t bits) { float16 h; h.bits_ = bits; return h; }
+
+private:
+  uint16_t bits_;
+};
+
+class bfloat16 {
+public:
+  static constexpr auto section = section_type::bf16;
+
+  bfloat16() = default;
+  bfloat16(float v) : bits_{detail::float_to_bfloat(v)} {}
+  bfloat16(float16 v) : bfloat16{float(v)} {}
+
+  operator float() const { return detail::bfloat_to_float(bits_); }
+
+  auto& operator+=(float v) { return *this = float(*this) + v; }
+  auto& operator-=(float v) { return *this = float(*this) - v; }
+  auto& operator*=(float v) { return *this = float(*this) * v; }
+  auto& operator/=(float v) { return *this = float(*this) / v; }
+
+  auto bits() const { return bits_; }
+  static auto from_bits(uint16_t bits) { bfloat16 h; h.bits_ = bits; return h; }
+
+private:
+  uint16_t bits_;
+};
+
+inline float16::float16(bfloat16 v) : float16{float(v)} {}
+
+// type in which elements are computed, storage types widen to float
+template <typename T> struct widened { using type = T; };
+template <> struct widened<float16>  { using type = float; };
+template <> struct widened<bfloat16> { using type = float; };
+
+template <typename T> using widened_t = typename widened< std::remove_cv_t<T> >::type;
+
+// Conversion kernels
+// dst[i] = src[i] for i < n between float and a half type, through the F16C (float16) or SSE2 (bfloat16) conversions
+// 8 elements at a time, 16 with AVX-512, the remaining ones in scalar
+inline void convert_n(const float16* src, size_t n, float* dst) {
+  size_t i = 0;
+#if defined(IG_F16C)
+# if defined(IG_AVX512)
+  for (; i + 16 <= n; i += 16) _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+# endif
+  for (; i + 8 <= n; i += 8) _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+#endif
+  for (; i < n; ++i) dst[i] = src[i];
+}
+
+inline void convert_n(const float* src, size_t n, float16* dst) {
+  size_t i = 0;
+#if defined(IG_F16C)
+# if defined(IG_AVX512)
+  for (; i + 16 <= n; i += 16) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+# endif
+  for (; i + 8 <= n; i += 8) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+  for (; i < n; ++i) dst[i] = src[i];
+}
+
+inline void convert_n(const bfloat16* src, size_t n, float* dst) {
+  size_t i = 0;
+#if defined(IG_AVX512)
+  for (; i + 16 <= n; i += 16) {
+    auto v = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    _mm512_storeu_si512(dst + i, _mm512_slli_epi32(v, 16));
+  }
+#endif
+#if defined(IG_SSE)
+  auto zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),     _mm_unpacklo_epi16(zero, v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(zero, v));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = src[i];
+}
+
+inline void convert_n(const float* src, size_t n, bfloat16* dst) {
+  size_t i = 0;
+#if defined(IG_AVX512) && defined(__AVX512BF16__) && defined(__AVX512VL__)
+  for (; i + 16 <= n; i += 16) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), (__m256i)_mm512_cvtneps_pbh(_mm512_loadu_ps(src + i)));
+  for (; i + 8 <= n; i += 8)   _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),    (__m128i)_mm256_cvtneps_pbh(_mm256_loadu_ps(src + i)));
+#elif defined(IG_SSE)
+  // rounded to nearest even on the integer bits, NaNs made quiet, and packed back without saturation
+  auto round = [one = _mm_set1_epi32(1), bias = _mm_set1_epi32(0x7fff), quiet = _mm_set1_epi32(0x40)](__m128 v) {
+    auto u = _mm_castps_si128(v);
+    auto nan = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+    auto r = _mm_srli_epi32(_mm_add_epi32(u, _mm_add_epi32(bias, _mm_and_si128(_mm_srli_epi32(u, 16), one))), 16);
+    r = _mm_or_si128(_mm_andnot_si128(nan, r), _mm_and_si128(nan, _mm_or_si128(_mm_srli_epi32(u, 16), quiet)));
+    return _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+  };
+  for (; i + 8 <= n; i += 8)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(round(_mm_loadu_ps(src + i)), round(_mm_loadu_ps(src + i + 4))));
+#endif
+  for (; i < n; ++i) dst[i] = src[i];
+}
+
+// same element types, or other conversions, element by element
+template
+< typename S,
+  typename T >
+void convert_n(const S* src, size_t n, T* dst) { std::copy_n(src, n, dst); }
+
+} // namespace ig
+
+#endif // IG_MATH_HALF_H
@@ -9,6 +9,9 @@
 
 #include "imagine/math/basis.h"
 #include "imagine/math/theory/detail/relational.h"
+#include "imagine/math/theory/detail/half.h"
+#include "imagine/core/mem/resource.h"
+#include "imagine/core/settings/serialize.h"
 
 #include <vector>
 #include <array>
@@ -38,7 +41,9 @@ template
   typename Rhs >
 class matrix_prod;
 template <typename Mat> class matrix_trans;
+template <typename Mat> class matrix_noalias;
 
+template <typename T>   class matrix_map;
 template <typename Xpr> class matrix_block;
 template <typename Xpr> class matrix_col;
 template <typename Xpr> class matrix_row;
@@ -51,6 +56,13 @@ template <typename Mat> class matrix_triang;
 template <typename Xpr> struct matrix_traits;
 template <typename Xpr> struct matrix_traits<const Xpr> : matrix_traits<Xpr> {};
 
+template <typename Xpr> struct is_matrix_unary : std::false_type {};
+template <typename M, typename F> struct is_matrix_unary< matrix_unary<M, F> > : std::true_type {};
+template <typename Xpr> struct is_matrix_binary : std::false_type {};
+template <typename L, typename R, typename F> struct is_matrix_binary< matrix_binary<L, R, F> > : std::true_type {};
+template <typename Xpr> struct is_matrix_prod : std::false_type {};
+template <typename L, typename R> struct is_matrix_prod< matrix_prod<L, R> > : std::true_type {};
+
 // Aliases
 template <typename Mat> using matrix_t = typename matrix_traits<Mat>::value_type;
 template <typename Mat> using concrete_matrix =
@@ -94,6 +106,9 @@ public:
   auto t() const    { return matrix_trans<const D>{derived()}; }
   auto t()          { return matrix_trans<D>      {derived()}; }
 
+  // assignments skipping the aliasing checks, the right-hand side must not read this matrix
+  auto noalias() { return matrix_noalias<D>{derived()}; }
+
   auto head(size_t n, size_t m) const { return matrix_block<const D>{derived(), 0, 0, std::min(n, rows()), std::min(m, cols())}; }
   auto head(size_t n, size_t m)       { return matrix_block<D>      {derived(), 0, 0, std::min(n, rows()), std::min(m, cols())}; }
   auto tail(size_t n, size_t m) const { return matrix_block<const D>{derived(), std::max(0, rows() - n), std::max(0, cols() - m), std::max(1, rows() - n), std::max(1, cols() - m)}; }
@@ -109,30 +124,28 @@ public:
   decltype(auto) operator[](size_t index)
   { return derived()[index]; }
 
-  auto& operator+=(value_type value)
-  { return derived() = std::move(*this) + value; }
-  auto& operator-=(value_type value)
-  { return derived() = std::move(*this) - value; }
-  auto& operator*=(value_type value)
-  { return derived() = std::move(*this) * value; }
-  auto& operator/=(value_type value)
-  { return derived() = std::move(*this) / value; }
+  auto& operator+=(value_type value) { return update(value, std::plus<>{}); }
+  auto& operator-=(value_type value) { return update(value, std::minus<>{}); }
+  auto& operator*=(value_type value) { return update(value, std::multiplies<>{}); }
+  auto& operator/=(value_type value) { return update(value, std::divides<>{}); }
 
   template <typename Mat>
-  auto& operator+=(const matrix_base<Mat>& mat) { return derived() = std::move(*this) + mat; }
+  auto& operator+=(const matrix_base<Mat>& mat) { return update(mat, std::plus<>{}); }
   template <typename Mat>
-  auto& operator-=(const matrix_base<Mat>& mat) { return derived() = std::move(*this) - mat; }
+  auto& operator-=(const matrix_base<Mat>& mat) { return update(mat, std::minus<>{}); }
   template <typename Mat>
-  auto& operator*=(const matrix_base<Mat>& mat) { return derived() = std::move(*this) * mat; }
+  auto& operator*=(const matrix_base<Mat>& mat) { return update(mat, std::multiplies<>{}); }
   template <typename Mat>
-  auto& operator/=(const matrix_base<Mat>& mat) { return derived() = std::move(*this) / mat; }
+  auto& operator/=(const matrix_base<Mat>& mat) { return update(mat, std::divides<>{}); }
   template <typename Mat>
-  auto& operator%=(const matrix_base<Mat>& mat) { return derived() = std::move(*this) % mat; }
+  auto& operator%=(const matrix_base<Mat>& mat) { return derived() = derived() % mat; }
 
   auto sum() const  -> value_type;
   auto prod() const -> value_type;
   auto mean() const -> value_type;
 
+  auto fingerprint() const -> hash128;
+
   class initializer {
   public:
     explicit initializer(D& mat)
@@ -156,8 +169,36 @@ public:
   };
 
   auto operator<<(value_type val) { return initializer{derived()}, val; }
+
+protected:
+  // in-place compound assignment, derived() = op(derived(), rhs) in a single pass
+  template <typename Op>
+  auto& update(value_type value, Op op);
+  template
+  < typename Mat,
+    typename Op >
+  auto& update(const matrix_base<Mat>& mat, Op op);
 };
 
+template <typename Xpr, typename = void> struct has_buffer : std::false_type {};
+template <typename Xpr> struct has_buffer< Xpr, std::void_t<decltype(std::declval<const Xpr&>().buffer())> > : std::true_type {};
+
+// Static evaluation
+// matrices whose dimensions are known at compile time are evaluated in a single unrolled sequence
+template <typename Xpr>
+constexpr bool is_static_matrix = matrix_traits<Xpr>::n_rows != dynamic_size && matrix_traits<Xpr>::n_cols != dynamic_size;
+
+template
+< typename T,
+  typename Mat,
+  size_t... I >
+void eval_fixed(T* dst, const Mat& mat, std::index_sequence<I...>)
+{ ((dst[I] = mat[I]), ...); }
+
+struct matrix_region;
+template <typename Xpr> auto matrix_region_of(const Xpr& xpr) -> matrix_region;
+template <typename Mat> bool overlapped(const matrix_base<Mat>& mat, const matrix_region& written);
+
 template <typename Gen, typename Mat>
 void eval_helper(matrix_base<Gen>& ev, const matrix_base<Mat>& mat) {
   assert(
@@ -165,9 +206,17 @@ void eval_helper(matrix_base<Gen>& ev, const matrix_base<Mat>& mat) {
     ev.cols() == mat.cols()
     && "Incoherent algebraic evaluation");
 
-  for (size_t i = 0; i < ev.size(); ++i)
-    ev [i] =
-    mat[i];
+  // products are evaluated in the destination, unless they read it
+  if constexpr (is_matrix_prod<Mat>::value) {
+    if (!overlapped(mat, matrix_region_of(ev.derived()))) return mat.derived().eval_into(ev, 1, 0);
+  }
+
+  if constexpr (has_buffer<Gen>::value && is_static_matrix<Gen> && is_static_matrix<Mat>)
+    eval_fixed(ev.derived().buffer(), mat.derived(), std::make_index_sequence<matrix_traits<Gen>::n_rows * matrix_traits<Gen>::n_cols>{});
+  else 
+    for (size_t i = 0; i < ev.size(); ++i)
+      ev [i] =
+      mat[i];
 }
 
 template <typename Gen, typename Mat>
@@ -184,6 +233,135 @@ void eval(matrix_base<Gen>& ev, const matrix_base<Mat>& mat, typename Gen::dynam
   eval_helper(ev, mat);
 }
 
+// Aliasing
+// rectangle of a row-major buffer covered by a leaf (matrix, matrix_map) or a view over it (block, col, row, diag),
+// exact when the view visits the rectangle in row-major order
+struct matrix_region {
+  const char* base = nullptr;
+  size_t element = 0, ld = 0;
+  size_t row = 0, col = 0, rows = 0, cols = 0;
+  bool exact = true;
+
+  auto begin() const { return base + (row * ld + col) * element; }
+  auto end() const   { return base + ((row + rows - 1) * ld + col + cols) * element; }
+
+  auto sub(size_t r, size_t c, size_t nr, size_t nc) const {
+    auto o = *this;
+    o.row += r; o.rows = nr;
+    o.col += c; o.cols = nc;
+    return o;
+  }
+
+  bool overlaps(const matrix_region& o) const {
+    if (!base || !o.base || !rows || !cols || !o.rows || !o.cols) return false;
+    if (base == o.base && ld == o.ld)
+      return row < o.row + o.rows && o.row < row + rows && col < o.col + o.cols && o.col < col + cols;
+    return begin() < o.end() && o.begin() < end();
+  }
+
+  bool same(const matrix_region& o) const {
+    return exact && o.exact && base == o.base && ld == o.ld && row == o.row && col == o.col && rows == o.rows && cols == o.cols;
+  }
+};
+
+template <typename Xpr, typename = void> struct has_region : std::false_type {};
+template <typename Xpr> struct has_region< Xpr, std::void_t<decltype(std::declval<const Xpr&>().region())> > : std::true_type {};
+
+template <typename Xpr>
+auto matrix_region_of(const Xpr& xpr) -> matrix_region {
+  if constexpr (has_buffer<Xpr>::value) 
+    return {reinterpret_cast<const char*>(xpr.buffer()), sizeof(matrix_t<Xpr>), xpr.cols(), 0, 0, xpr.rows(), xpr.cols()};
+  else if constexpr (has_region<Xpr>::value) return xpr.region();
+  else 
+    return {};
+}
+
+template <typename Xpr> struct is_materialized : std::false_type {};
+template <typename L, typename R> struct is_materialized< matrix_prod<L, R> > : std::true_type {};
+template <typename M>             struct is_materialized< matrix_trans<M> >   : std::true_type {};
+
+// whether evaluating mat element by element into the written region may read an element already overwritten,
+// unary and binary expressions hold copies of their leaves but keep views on the original memory, products are
+// evaluated on their first element read and transposes on construction, unknown nodes are assumed to alias
+template <typename Mat>
+bool aliased(const matrix_base<Mat>& mat, const matrix_region& written) {
+  auto& xpr = mat.derived();
+  if (!written.base) return false;
+
+  if constexpr (is_materialized<Mat>::value) return false;
+  else if constexpr (has_buffer<Mat>::value || has_region<Mat>::value) {
+    auto r = matrix_region_of(xpr);
+    return !r.base || (r.overlaps(written) && !r.same(written));
+  } else if constexpr (is_matrix_unary<Mat>::value) return aliased(xpr.operand(), written);
+  else if constexpr (is_matrix_binary<Mat>::value) return aliased(xpr.lhs(), written) || aliased(xpr.rhs(), written);
+  else 
+    return true;
+}
+
+// whether mat reads any element of the written region, products evaluated in place read whole rows and columns
+// of their operands
+template <typename Mat>
+bool overlapped(const matrix_base<Mat>& mat, const matrix_region& written) {
+  auto& xpr = mat.derived();
+  if (!written.base) return false;
+
+  if constexpr (is_matrix_prod<Mat>::value) return overlapped(xpr.lhs(), written) || overlapped(xpr.rhs(), written);
+  else if constexpr (is_materialized<Mat>::value) return false;
+  else if constexpr (has_buffer<Mat>::value || has_region<Mat>::value) {
+    auto r = matrix_region_of(xpr);
+    return !r.base || r.overlaps(written);
+  } else if constexpr (is_matrix_unary<Mat>::value) return overlapped(xpr.operand(), written);
+  else if constexpr (is_matrix_binary<Mat>::value) return overlapped(xpr.lhs(), written) || overlapped(xpr.rhs(), written);
+  else 
+    return true;
+}
+
+// in-place updates over the buffer when there is one, operands read through aliased views are copied first
+template <typename D>
+template <typename Op>
+auto& matrix_base<D>::update(value_type value, Op op) {
+  auto& ev = derived();
+  if constexpr (has_buffer<D>::value) {
+    auto dst = ev.buffer();
+    for (size_t i = 0; i < size(); ++i) dst[i] = op(dst[i], value);
+  } else 
+    for (size_t i = 0; i < size(); ++i) ev[i] = op(ev[i], value);
+  return ev;
+}
+
+template <typename D>
+template
+< typename Mat,
+  typename Op >
+auto& matrix_base<D>::update(const matrix_base<Mat>& mat, Op op) {
+  assert(
+    rows() == mat.rows() &&
+    cols() == mat.cols()
+    && "Incoherent algebraic evaluation");
+
+  auto& ev = derived();
+  auto apply = [&](const auto& src) {
+    if constexpr (has_buffer<D>::value) {
+      auto dst = ev.buffer();
+      for (size_t i = 0; i < size(); ++i) dst[i] = op(dst[i], src[i]);
+    } else 
+      for (size_t i = 0; i < size(); ++i) ev[i] = op(ev[i], src[i]);
+  };
+
+  // sums and differences of a product are accumulated by the product itself
+  if constexpr (is_matrix_prod<Mat>::value && (std::is_same_v<Op, std::plus<>> || std::is_same_v<Op, std::minus<>>)) {
+    if (!overlapped(mat, matrix_region_of(ev))) {
+      mat.derived().eval_into(ev, std::is_same_v<Op, std::plus<>> ? 1 : -1, 1);
+      return ev;
+    }
+  }
+
+  if (aliased(mat, matrix_region_of(ev))) apply(concrete_matrix<Mat>{mat});
+  else 
+    apply(mat.derived());
+  return ev;
+}
+
 // Cwise
 template <typename D>
 auto matrix_base<D>::sum() const -> value_type {
@@ -206,6 +384,11 @@ template <typename D>
 auto matrix_base<D>::mean() const -> value_type
 { return sum() / size(); }
 
+// expressions are materialized before hashing
+template <typename D>
+auto matrix_base<D>::fingerprint() const -> hash128
+{ return matrix<value_type, dynamic_size, dynamic_size>{derived()}.fingerprint(); }
+
 template <typename Mat>
 inline std::ostream& operator<<(std::ostream& stream, const matrix_base<Mat>& mat) {
   size_t width = 0;
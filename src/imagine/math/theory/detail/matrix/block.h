@@ -39,8 +39,10 @@ public:
   decltype(auto) operator()(size_t row, size_t col)
   { return xpr_(row_ + row, col_ + col); }
 
-  decltype(auto) operator[](size_t n) const { return xpr_((row_ + n) / nr_, (col_ + n) % nc_); }
-  decltype(auto) operator[](size_t n)       { return xpr_((row_ + n) / nr_, (col_ + n) % nc_); }
+  decltype(auto) operator[](size_t n) const { return xpr_(row_ + n / nc_, col_ + n % nc_); }
+  decltype(auto) operator[](size_t n)       { return xpr_(row_ + n / nc_, col_ + n % nc_); }
+
+  auto region() const { return matrix_region_of(xpr_).sub(row_, col_, nr_, nc_); }
 
   template <typename Mat>
   auto operator=(const matrix_base<Mat>& o) { return eval(*this, o); }
@@ -36,6 +36,8 @@ public:
   decltype(auto) operator[](size_t n)
   { return xpr_(n, col_); }
 
+  auto region() const { return matrix_region_of(xpr_).sub(0, col_, rows(), 1); }
+
   template <typename Mat>
   auto operator=(const matrix_base<Mat>& o) { return eval(*this, o); }
 
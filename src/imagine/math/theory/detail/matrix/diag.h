@@ -35,6 +35,12 @@ public:
   decltype(auto) operator[](size_t n)
   { return xpr_(n, n); }
 
+  auto region() const { 
+    auto r = matrix_region_of(xpr_).sub(0, 0, rows(), rows());
+    r.exact = false;
+    return r;
+  }
+
   template <typename Mat>
   auto operator=(const matrix_base<Mat>& o) { return eval(*this, o); }
 
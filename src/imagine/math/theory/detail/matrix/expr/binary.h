@@ -21,8 +21,8 @@ struct matrix_traits
 >
 {
   using value_type = std::common_type_t
-    < matrix_t<Lhs>,
-      matrix_t<Rhs>
+    < widened_t<matrix_t<Lhs>>,
+      widened_t<matrix_t<Rhs>>
     >; static constexpr auto n_rows = matrix_traits<Lhs>::n_rows, n_cols = matrix_traits<Lhs>::n_cols;
 };
 
@@ -45,6 +45,9 @@ public:
   auto operator[](size_t n) const
   { return op_(lhs_[n], rhs_[n]); }
 
+  auto& lhs() const { return lhs_; }
+  auto& rhs() const { return rhs_; }
+
 private:
   l_ lhs_;
   r_ rhs_;
@@ -8,6 +8,9 @@
 #define IG_MATH_MATRIXPROD_H
 
 #include "imagine/math/theory/detail/matrix/base.h"
+#include "imagine/math/theory/detail/gemv.h"
+
+#include <optional>
 
 namespace ig {
 
@@ -20,8 +23,8 @@ struct matrix_traits
 >
 {
   using value_type = std::common_type_t
-    < matrix_t<Lhs>,
-      matrix_t<Rhs>
+    < widened_t<matrix_t<Lhs>>,
+      widened_t<matrix_t<Rhs>>
     >;
   static constexpr auto dyn =
     matrix_traits<Lhs>::n_rows == dynamic_size ||
@@ -30,51 +33,198 @@ struct matrix_traits
                         n_cols = dyn ? dynamic_size : matrix_traits<Rhs>::n_cols;
 };
 
+// Packed products
+// products of at least gemm_threshold multiply-adds run through the blocked kernels (see gemm.h),
+// smaller ones would spend more time packing than computing, and on every worker from gemm_parallel
+constexpr size_t gemm_threshold = 8 * 8 * 8;
+
+// calls fn with a gemm_operand over xpr, leaves and row-major views over them are read in place,
+// other expressions are evaluated first
+template
+< typename Xpr,
+  typename Fn >
+void gemm_operand_of(const Xpr& xpr, Fn&& fn) {
+  using S = matrix_t<Xpr>;
+  if constexpr (has_buffer<Xpr>::value) fn(gemm_operand<S>{xpr.buffer(), xpr.cols(), 1});
+  else {
+    if constexpr (has_region<Xpr>::value) {
+      auto r = xpr.region();
+      if (r.base && r.exact && r.element == sizeof(S))
+        return fn(gemm_operand<S>{reinterpret_cast<const S*>(r.begin()), r.ld, 1});
+    }
+    matrix<S, dynamic_size, dynamic_size> mat{xpr};
+    fn(gemm_operand<S>{mat.buffer(), mat.cols(), 1});
+  }
+}
+
+// products are evaluated once the expression is assigned, leaves given as lvalues are referenced and
+// temporary ones moved in so that the product may outlive its full expression, other operands (views,
+// expressions) are held by value
+template <typename Xpr> struct is_matrix_leaf : std::false_type {};
+template <typename T, size_t M, size_t N> struct is_matrix_leaf< matrix<T, M, N> > : std::true_type {};
+
+template 
+< typename Xpr, 
+  bool = is_matrix_leaf<Xpr>::value >
+class prod_operand {
+public:
+  prod_operand(Xpr xpr) : xpr_{std::move(xpr)} {}
+  auto& get() const { return xpr_; }
+
+private:
+  Xpr xpr_;
+};
+
+template <typename Xpr>
+class prod_operand<Xpr, true> {
+public:
+  prod_operand(const Xpr& xpr) : ref_{&xpr} {}
+  prod_operand(Xpr&& xpr) : own_{std::move(xpr)}, ref_{nullptr} {}
+  auto& get() const { return ref_ ? *ref_ : *own_; }
+
+private:
+  std::optional<Xpr> own_;
+  const Xpr* ref_;
+};
+
 template
 < typename l_,
   typename r_ >
 class matrix_prod : public matrix_base< matrix_prod<l_, r_> > {
 public:
+  using value_type = matrix_t<matrix_prod>;
   using matrix_type = concrete_matrix<matrix_prod>;
-  explicit matrix_prod(const l_& lhs, const r_& rhs)
-    : matrix_prod{
-        lhs,
-        rhs,
-        std::integral_constant<bool, matrix_type::immutable>{}}
-  { eval_product(lhs, rhs); }
+  template <typename L, typename R>
+  explicit matrix_prod(L&& lhs, R&& rhs)
+    : lhs_{std::forward<L>(lhs)}
+    , rhs_{std::forward<R>(rhs)} {}
 
-  matrix_prod(const l_& lhs, const r_& rhs, std::true_type)  : prod_{} {}
-  matrix_prod(const l_& lhs, const r_& rhs, std::false_type) : prod_{lhs.rows(), rhs.cols()} {}
+  auto rows() const { return lhs().rows(); }
+  auto cols() const { return rhs().cols(); }
 
-  auto rows() const { return prod_.rows(); }
-  auto cols() const { return prod_.cols(); }
+  // elements are read from the product evaluated on first access
+  auto buffer() const { return product().buffer(); }
 
   decltype(auto) operator()(size_t row, size_t col) const
-  { return prod_(row, col); }
-  decltype(auto) operator()(size_t row, size_t col)
-  { return prod_(row, col); }
-
+  { return product()(row, col); }
   decltype(auto) operator[](size_t n) const
-  { return prod_[n]; }
-  decltype(auto) operator[](size_t n)
-  { return prod_[n]; }
+  { return product()[n]; }
+
+  auto& lhs() const { return lhs_.get(); }
+  auto& rhs() const { return rhs_.get(); }
+
+  // ev = alpha * lhs % rhs + beta * ev, straight into the storage of ev when it is a row-major rectangle
+  // of value_type, ev must not overlap the operands (see overlapped)
+  template <typename Gen>
+  void eval_into(matrix_base<Gen>& ev, value_type alpha, value_type beta) const;
 
 private:
-  void eval_product(const l_& lhs, const r_& rhs) {
-    for (size_t i = 0; i < lhs.rows(); ++i)
-      for (size_t j = 0; j < lhs.cols(); ++j)
-        for (size_t k = 0; k < rhs.cols(); ++k)
-          prod_[i * rhs.cols() + k] +=
-            lhs[i * lhs.cols() + j] *
-            rhs[j * rhs.cols() + k];
-          /*prod_(i, k) +=
-            lhs(i, j) *
-            rhs(j, k);*/
-  }
+  auto product() const -> const matrix_type&;
+  void eval_into(value_type* c, size_t ldc, value_type alpha, value_type beta) const;
+
+  // static products accumulate the rows of rhs scaled by lhs(i, j) in a fully unrolled sequence,
+  // dimensions and offsets are folded into the code
+  static constexpr size_t M = matrix_traits<l_>::n_rows, K = matrix_traits<l_>::n_cols, N = matrix_traits<r_>::n_cols;
+
+  template <size_t... IJ>
+  static void eval_fixed(value_type* dst, const l_& lhs, const r_& rhs, std::index_sequence<IJ...>)
+  { (eval_fixed_row<IJ / K>(dst, lhs[IJ], rhs, IJ % K * N, std::make_index_sequence<N>{}), ...); }
+
+  template 
+  < size_t I, 
+    size_t... C >
+  static void eval_fixed_row(value_type* dst, value_type a, const r_& rhs, size_t offset, std::index_sequence<C...>)
+  { ((dst[I * N + C] += a * rhs[offset + C]), ...); }
 
-  matrix_type prod_;
+  prod_operand<l_> lhs_;
+  prod_operand<r_> rhs_;
+  mutable std::optional<matrix_type> prod_;
 };
 
+template
+< typename l_,
+  typename r_ >
+auto matrix_prod<l_, r_>::product() const -> const matrix_type& {
+  if (!prod_) {
+    if constexpr (matrix_type::immutable) prod_.emplace();
+    else 
+      prod_.emplace(rows(), cols());
+    eval_into(prod_->buffer(), cols(), 1, 0);
+  } return *prod_;
+}
+
+template
+< typename l_,
+  typename r_ >
+template <typename Gen>
+void matrix_prod<l_, r_>::eval_into(matrix_base<Gen>& ev, value_type alpha, value_type beta) const {
+  assert(
+    ev.rows() == rows() &&
+    ev.cols() == cols()
+    && "Incoherent algebraic evaluation");
+
+  if constexpr (std::is_same_v<std::remove_cv_t<matrix_t<Gen>>, value_type>) {
+    if constexpr (has_buffer<Gen>::value) return eval_into(ev.derived().buffer(), ev.cols(), alpha, beta);
+    else {
+      auto r = matrix_region_of(ev.derived());
+      if (r.base && r.exact)
+        return eval_into(const_cast<value_type*>(reinterpret_cast<const value_type*>(r.begin())), r.ld, alpha, beta);
+    }
+  }
+
+  // other destinations are written element by element from the evaluated product
+  auto& p = product();
+  for (size_t i = 0; i < ev.size(); ++i)
+    ev[i] = beta == value_type(0) ? alpha * p[i] : alpha * p[i] + beta * ev[i];
+}
+
+template
+< typename l_,
+  typename r_ >
+void matrix_prod<l_, r_>::eval_into(value_type* c, size_t ldc, value_type alpha, value_type beta) const {
+  auto& lhs = this->lhs();
+  auto& rhs = this->rhs();
+  auto m = rows(), n = cols(), k = lhs.cols();
+  if constexpr (matrix_type::immutable && is_static_matrix<l_> && is_static_matrix<r_>) {
+    value_type p[M * N] = {};
+    eval_fixed(p, lhs, rhs, std::make_index_sequence<M * K>{});
+    if (alpha == value_type(1) && beta == value_type(0) && ldc == N) std::copy_n(p, M * N, c);
+    else 
+      for (size_t i = 0; i < M; ++i)
+        for (size_t j = 0; j < N; ++j)
+          c[i * ldc + j] = beta == value_type(0) ? alpha * p[i * N + j] : alpha * p[i * N + j] + beta * c[i * ldc + j];
+    return;
+  }
+
+  gemm_scale(c, ldc, m, n, beta);
+  auto work = m * k * n;
+
+  // matrix-vector products stream the matrix once (see gemv.h), vector-matrix ones as the transposed product
+  if (n == 1 || m == 1) {
+    size_t threads = work < gemv_parallel ? 1 : 0;
+    return gemm_operand_of(lhs, [&](auto a) { 
+      gemm_operand_of(rhs, [&](auto b) { 
+        if (n == 1) gemv_into(c, ldc, a, b, m, k, alpha, threads);
+        else 
+          gemv_into(c, size_t(1), b.t(), a.t(), n, k, alpha, threads);
+      }); 
+    });
+  }
+
+  size_t threads = work < gemm_parallel ? 1 : 0;
+  if (work >= gemm_threshold) 
+    return gemm_operand_of(lhs, [&](auto a) { 
+      gemm_operand_of(rhs, [&](auto b) { gemm_into(c, ldc, a, b, m, n, k, alpha, threads); }); 
+    });
+
+  for (size_t i = 0; i < m; ++i)
+    for (size_t j = 0; j < k; ++j) {
+      auto a = alpha * lhs[i * k + j];
+      for (size_t q = 0; q < n; ++q)
+        c[i * ldc + q] += a * rhs[j * n + q];
+    }
+}
+
 template <typename Lhs, typename Rhs>
 constexpr auto operator%(const matrix_base<Lhs>& lhs, const matrix_base<Rhs>& rhs) {
   assert(lhs.cols() == rhs.rows() && "Incoherent matrix-matrix multiplication");
@@ -84,6 +234,46 @@ constexpr auto operator%(const matrix_base<Lhs>& lhs, const matrix_base<Rhs>& rh
     >{lhs.derived(), rhs.derived()};
 }
 
+// temporaries are moved into the product (see prod_operand)
+template <typename Lhs, typename Rhs>
+constexpr auto operator%(matrix_base<Lhs>&& lhs, const matrix_base<Rhs>& rhs) {
+  assert(lhs.cols() == rhs.rows() && "Incoherent matrix-matrix multiplication");
+  return matrix_prod
+    < Lhs,
+      Rhs
+    >{std::move(lhs.derived()), rhs.derived()};
+}
+
+template <typename Lhs, typename Rhs>
+constexpr auto operator%(const matrix_base<Lhs>& lhs, matrix_base<Rhs>&& rhs) {
+  assert(lhs.cols() == rhs.rows() && "Incoherent matrix-matrix multiplication");
+  return matrix_prod
+    < Lhs,
+      Rhs
+    >{lhs.derived(), std::move(rhs.derived())};
+}
+
+template <typename Lhs, typename Rhs>
+constexpr auto operator%(matrix_base<Lhs>&& lhs, matrix_base<Rhs>&& rhs) {
+  assert(lhs.cols() == rhs.rows() && "Incoherent matrix-matrix multiplication");
+  return matrix_prod
+    < Lhs,
+      Rhs
+    >{std::move(lhs.derived()), std::move(rhs.derived())};
+}
+
+// c = alpha * a % b + beta * c in the storage of c, which must not overlap a or b,
+// the updates of iterative methods run without temporaries
+template
+< typename Lhs,
+  typename Rhs,
+  typename Mat >
+void gemm(matrix_t< matrix_prod<Lhs, Rhs> > alpha, const matrix_base<Lhs>& a, const matrix_base<Rhs>& b, matrix_t< matrix_prod<Lhs, Rhs> > beta, matrix_base<Mat>& c) {
+  auto prod = a % b;
+  assert(!overlapped(prod, matrix_region_of(c.derived())) && "Product operands overlap the destination");
+  prod.eval_into(c, alpha, beta);
+}
+
 } // namespace ig
 
 #endif // IG_MATH_MATRIXPROD_H
@@ -8,6 +8,7 @@
 #define IG_MATH_MATRIXTRANS_H
 
 #include "imagine/math/theory/detail/matrix/base.h"
+#include "imagine/math/theory/detail/transposition.h"
 
 namespace ig {
 
@@ -34,8 +35,11 @@ public:
   matrix_trans(const x_& xpr, std::true_type)  : trans_{} {}
   matrix_trans(const x_& xpr, std::false_type) : trans_{xpr.cols(), xpr.rows()} {}
 
-  auto rows() const { return trans_.cols(); }
-  auto cols() const { return trans_.rows(); }
+  auto rows() const { return trans_.rows(); }
+  auto cols() const { return trans_.cols(); }
+
+  auto buffer() const { return trans_.buffer(); }
+  auto buffer()       { return trans_.buffer(); }
 
   decltype(auto) operator()(size_t row, size_t col) const
   { return trans_(row, col); }
@@ -48,11 +52,14 @@ public:
   { return trans_[n]; }
 
 private:
+  // leaves are transposed tile by tile, other expressions element by element
   void eval_transpose(const x_& xpr) {
-    for (size_t i = 0; i < xpr.rows(); ++i)
-      for (size_t j = 0; j < xpr.cols(); ++j)
-        trans_[j * xpr.cols() + i] =
-           xpr[i * xpr.cols() + j];
+    if constexpr (has_buffer<x_>::value) transpose_into(trans_.buffer(), xpr.rows(), xpr.buffer(), xpr.cols(), xpr.rows(), xpr.cols());
+    else
+      for (size_t i = 0; i < xpr.rows(); ++i)
+        for (size_t j = 0; j < xpr.cols(); ++j)
+          trans_[j * xpr.rows() + i] =
+             xpr[i * xpr.cols() + j];
   }
 
   matrix_type trans_;
@@ -45,6 +45,8 @@ public:
   auto operator[](size_t n) const
   { return op_(mat_[n]); }
 
+  auto& operand() const { return mat_; }
+
 private:
   m_ mat_;
   f_ op_;
@@ -0,0 +1,59 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_MATRIXMAP_H
+#define IG_MATH_MATRIXMAP_H
+
+#include "imagine/math/theory/detail/matrix/base.h"
+
+namespace ig {
+
+template <typename T>
+struct matrix_traits
+<
+  matrix_map<T>
+>
+{
+  using value_type = T;
+  static constexpr auto n_rows = dynamic_size, n_cols = dynamic_size;
+};
+
+// row-major matrix over external memory, the holder keeps the memory alive
+template <typename t_>
+class matrix_map : public matrix_base< matrix_map<t_> > {
+public:
+  explicit matrix_map(t_* data, size_t rows, size_t cols, std::shared_ptr<const void> holder = {})
+    : data_{data}
+    , rows_{rows}
+    , cols_{cols}
+    , holder_{std::move(holder)} {}
+
+  auto rows() const { return rows_; }
+  auto cols() const { return cols_; }
+
+  auto buffer() const { return static_cast<const t_*>(data_); }
+  auto buffer()       { return data_; }
+
+  auto fingerprint() const { return ig::fingerprint(data_, rows_ * cols_, std::array<size_t, 2>{rows_, cols_}); }
+
+  auto& operator()(size_t row, size_t col) const { return data_[row * cols_ + col]; }
+  auto& operator()(size_t row, size_t col)       { return data_[row * cols_ + col]; }
+
+  auto& operator[](size_t n) const { return data_[n]; }
+  auto& operator[](size_t n)       { return data_[n]; }
+
+  template <typename Mat>
+  auto& operator=(const matrix_base<Mat>& o) { eval_helper(*this, o); return *this; }
+
+private:
+  t_* data_;
+  size_t rows_, cols_;
+  std::shared_ptr<const void> holder_;
+};
+
+} // namespace ig
+
+#endif // IG_MATH_MATRIXMAP_H
@@ -0,0 +1,56 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_MATRIXNOALIAS_H
+#define IG_MATH_MATRIXNOALIAS_H
+
+#include "imagine/math/theory/detail/matrix/base.h"
+
+namespace ig {
+
+// Destination of assignments whose right-hand side does not read it, e.g. v.noalias() = A % p,
+// products are evaluated straight into the destination, which is only reshaped when its dimensions change
+template <typename x_>
+class matrix_noalias {
+public:
+  explicit matrix_noalias(x_& xpr)
+    : xpr_{xpr} {}
+
+  template <typename Mat>
+  auto& operator=(const matrix_base<Mat>& o) {
+    if (xpr_.rows() != o.rows() || xpr_.cols() != o.cols()) xpr_ = o;
+    else if constexpr (is_matrix_prod<Mat>::value) o.derived().eval_into(xpr_, 1, 0);
+    else 
+      eval_helper(xpr_, o);
+    return xpr_;
+  }
+
+  template <typename Mat>
+  auto& operator+=(const matrix_base<Mat>& o) { return update(o, 1); }
+  template <typename Mat>
+  auto& operator-=(const matrix_base<Mat>& o) { return update(o, -1); }
+
+private:
+  template <typename Mat>
+  auto& update(const matrix_base<Mat>& o, int sign) {
+    if constexpr (is_matrix_prod<Mat>::value) {
+      assert(
+        xpr_.rows() == o.rows() &&
+        xpr_.cols() == o.cols()
+        && "Incoherent algebraic evaluation");
+      o.derived().eval_into(xpr_, sign, 1);
+    } else if (sign > 0) xpr_ += o;
+    else 
+      xpr_ -= o;
+    return xpr_;
+  }
+
+  x_& xpr_;
+};
+
+} // namespace ig
+
+#endif // IG_MATH_MATRIXNOALIAS_H
@@ -36,6 +36,8 @@ public:
   decltype(auto) operator[](size_t n)
   { return xpr_(row_, n); }
 
+  auto region() const { return matrix_region_of(xpr_).sub(row_, 0, 1, cols()); }
+
   template <typename Mat>
   auto operator=(const matrix_base<Mat>& o) { return eval(*this, o); }
 
@@ -22,10 +22,272 @@ constexpr auto linspace(T start, T end, T count) {
   return arr;
 }
 
-// grid
+// Layouts
+// dense strides of a shape (first dimension fastest)
+template <typename Shape>
+auto dense_strides(const Shape& shape) {
+  inline_shape<> extents, strides;
+  linear_layout(extents, strides, shape);
+  return strides;
+}
+
+template <typename Xpr>
+using domain_of = domain< const Xpr&, inline_shape<>, inline_shape<> >;
+
+} // namespace nd
+
+template <typename Xpr>
+struct ndarray_traits
+<
+  tiling<Xpr>
+>
+{
+  using value_type = ndarray_t<Xpr>;
+};
+
+template <typename Lhs, typename Rhs>
+struct ndarray_traits
+<
+  concatenation<Lhs, Rhs>
+>
+{
+  using value_type = std::common_type_t<ndarray_t<Lhs>, ndarray_t<Rhs>>;
+};
+
+// Tiling
+// the source repeated reps[d] times along each dimension d, missing repetitions are 1 and missing
+// source dimensions have extent 1, assignment copies each source row once and repeats it in place
+template <typename x_>
+class tiling : public ndarray_base< tiling<x_> > {
+public:
+  explicit tiling(x_ xpr, const nd::inline_shape<>& reps)
+    : xpr_{xpr}
+    , size_{1} {
+
+    auto dims = std::max(xpr_.dims(), reps.size());
+    source_.assign(dims, 1);
+    std::copy(xpr_.shape().begin(), xpr_.shape().end(), source_.begin());
+    sstrides_ = nd::dense_strides(source_);
+    for (size_t d = 0; d < dims; ++d) {
+      shape_.push_back(source_[d] * (d < reps.size() ? reps[d] : 1));
+      strides_.push_back(size_);
+      size_ *= shape_[d];
+    }
+  }
+
+  auto size() const { return size_; }
+  auto dims() const { return shape_.size(); }
+  auto& shape() const   { return shape_; }
+  auto& strides() const { return strides_; }
+
+  template <typename... Id>
+  auto operator()(Id... ids) const {
+    size_t is[] = {size_t(ids)...};
+    return eval(std::inner_product(std::begin(is), std::end(is), strides_.begin(), size_t(0)));
+  }
+
+  auto eval(size_t id) const {
+    size_t at = 0;
+    for (size_t d = 0; d < dims(); ++d) {
+      at += (id % shape_[d]) % source_[d] * sstrides_[d];
+      id /= shape_[d];
+    } return xpr_.eval(at);
+  }
+
+  static constexpr bool direct = true;
+
+  template <typename T>
+  void eval_into(T* dst, const nd::eval_policy& policy) const {
+    auto length = shape_[0], row = source_[0];
+    auto rows = size_ / length;
+    auto walk = [&](size_t begin, size_t end) {
+      for (auto r = begin; r < end; ++r) {
+        size_t at = 0;
+        for (size_t d = 1, p = r; d < dims(); ++d) {
+          at += (p % shape_[d]) % source_[d] * sstrides_[d];
+          p /= shape_[d];
+        }
+        auto out = dst + r * length;
+        eval_span(out, xpr_, at, row);
+        for (auto j = row; j < length; j += row) std::copy_n(out, row, out + j);
+      }
+    };
+
+    auto threads = size_ < policy.threshold ? 1 : policy.threads;
+    if (threads == 1) walk(0, rows);
+    else
+      job::get().parallel_for(rows, std::max<size_t>(1, policy.chunk / (sizeof(T) * length)), walk, threads);
+  }
+
+  auto operands() const { return std::forward_as_tuple(xpr_); }
+
+private:
+  x_ xpr_;
+  nd::inline_shape<> source_, sstrides_;
+  nd::inline_shape<> shape_, strides_;
+  size_t size_;
+};
+
+// Concatenation
+// lhs followed by rhs along an axis, shapes agree elsewhere, every block of dimensions up to
+// the axis is made of a contiguous block of lhs and one of rhs
+template
+< typename l_,
+  typename r_ >
+class concatenation : public ndarray_base< concatenation<l_, r_> > {
+public:
+  using value_type = ndarray_t<concatenation>;
+
+  explicit concatenation(l_ lhs, r_ rhs, size_t axis)
+    : lhs_{lhs}
+    , rhs_{rhs}
+    , shape_{lhs.shape().begin(), lhs.shape().end()}
+    , lblock_{1}
+    , rblock_{1} {
+
+    if (axis >= lhs_.dims() || lhs_.dims() != rhs_.dims())
+      throw std::runtime_error{"[Ndarray] Invalid concatenation axis " + std::to_string(axis)};
+    for (size_t d = 0; d < lhs_.dims(); ++d) {
+      if (d != axis && lhs_.shape()[d] != rhs_.shape()[d])
+        throw std::runtime_error{"[Ndarray] Concatenated shapes differ along dimension " + std::to_string(d)};
+      if (d <= axis) {
+        lblock_ *= lhs_.shape()[d];
+        rblock_ *= rhs_.shape()[d];
+      }
+    }
+    shape_[axis] += rhs_.shape()[axis];
+    strides_ = nd::dense_strides(shape_);
+  }
+
+  auto size() const { return lhs_.size() + rhs_.size(); }
+  auto dims() const { return shape_.size(); }
+  auto& shape() const   { return shape_; }
+  auto& strides() const { return strides_; }
+
+  template <typename... Id>
+  auto operator()(Id... ids) const {
+    size_t is[] = {size_t(ids)...};
+    return eval(std::inner_product(std::begin(is), std::end(is), strides_.begin(), size_t(0)));
+  }
+
+  auto eval(size_t id) const {
+    auto block = lblock_ + rblock_;
+    auto o = id / block, r = id % block;
+    return r < lblock_ ? value_type(lhs_.eval(o * lblock_ + r)) : value_type(rhs_.eval(o * rblock_ + r - lblock_));
+  }
+
+  static constexpr bool direct = true;
+
+  template <typename T>
+  void eval_into(T* dst, const nd::eval_policy& policy) const {
+    auto block = lblock_ + rblock_;
+    auto blocks = size() / block;
+    auto walk = [&](size_t begin, size_t end) {
+      for (auto o = begin; o < end; ++o) {
+        eval_span(dst + o * block,           lhs_, o * lblock_, lblock_);
+        eval_span(dst + o * block + lblock_, rhs_, o * rblock_, rblock_);
+      }
+    };
+
+    auto threads = size() < policy.threshold ? 1 : policy.threads;
+    if (threads == 1) walk(0, blocks);
+    else
+      job::get().parallel_for(blocks, std::max<size_t>(1, policy.chunk / (sizeof(T) * block)), walk, threads);
+  }
+
+  auto operands() const { return std::forward_as_tuple(lhs_, rhs_); }
+
+private:
+  l_ lhs_;
+  r_ rhs_;
+  nd::inline_shape<> shape_, strides_;
+  size_t lblock_, rblock_;
+};
+
+namespace nd {
+
+// Manipulations
+// lazy over their operands (held by reference), nothing is copied until assigned
+
+// same elements in the same (linear) order under another shape
+template
+< typename Xpr,
+  typename Shape >
+auto reshape(const ndarray_base<Xpr>& xpr, const Shape& shape) {
+  inline_shape<> extents{shape.begin(), shape.end()};
+  if (std::accumulate(extents.begin(), extents.end(), size_t(1), std::multiplies<>{}) != xpr.size())
+    throw std::runtime_error{"[Ndarray] Cannot reshape " + std::to_string(xpr.size()) + " elements"};
+  return domain_of<Xpr>{xpr.derived(), extents, dense_strides(extents)};
+}
+
+template <typename Xpr>
+auto reshape(const ndarray_base<Xpr>& xpr, std::initializer_list<size_t> shape) { return reshape(xpr, inline_shape<>(shape)); }
+
+// dimensions of extent 1 removed, all of them or those along axes
+template <typename Xpr>
+auto squeeze(const ndarray_base<Xpr>& xpr) {
+  inline_shape<> extents;
+  for (auto n : xpr.shape()) if (n != 1) extents.push_back(n);
+  if (extents.empty()) extents.push_back(1);
+  return reshape(xpr, extents);
+}
+
+template <typename Xpr>
+auto squeeze(const ndarray_base<Xpr>& xpr, const axes& axes) {
+  std::vector<bool> removed(xpr.dims(), false);
+  for (auto axis : axes.v) {
+    if (axis >= xpr.dims() || xpr.shape()[axis] != 1)
+      throw std::runtime_error{"[Ndarray] Cannot squeeze axis " + std::to_string(axis)};
+    removed[axis] = true;
+  }
+
+  inline_shape<> extents;
+  for (size_t d = 0; d < xpr.dims(); ++d) if (!removed[d]) extents.push_back(xpr.shape()[d]);
+  if (extents.empty()) extents.push_back(1);
+  return reshape(xpr, extents);
+}
+
+// sections consecutive windows of equal extent along an axis
+template <typename Xpr>
+auto split(const ndarray_base<Xpr>& xpr, size_t sections, size_t axis = 0) {
+  if (axis >= xpr.dims() || !sections || xpr.shape()[axis] % sections)
+    throw std::runtime_error{"[Ndarray] Cannot split axis " + std::to_string(axis) + " in " + std::to_string(sections) + " sections"};
+
+  inline_shape<> extents{xpr.shape().begin(), xpr.shape().end()};
+  auto strides = dense_strides(extents);
+  extents[axis] /= sections;
+
+  std::vector< domain_of<Xpr> > parts;
+  parts.reserve(sections);
+  for (size_t k = 0; k < sections; ++k) parts.emplace_back(xpr.derived(), extents, strides, k * extents[axis] * strides[axis]);
+  return parts;
+}
+
+// coordinate arrays of a grid, the k-th one repeats the k-th vector along every other dimension
+template <typename... Xprs>
+auto grid(const ndarray_base<Xprs>&... xprs) {
+  assert(((xprs.dims() == 1) && ...) && "Grid coordinates must be vectors");
+  inline_shape<> extents{xprs.size()...};
+
+  size_t k = 0;
+  auto axis = [&](auto& xpr) {
+    inline_shape<> strides(extents.size(), 0);
+    strides[k++] = 1;
+    return domain_of< std::decay_t<decltype(xpr.derived())> >{xpr.derived(), extents, strides};
+  };
+  return std::tuple{axis(xprs)...};
+}
+
+// the array repeated reps[d] times along each dimension d
+template <typename Xpr>
+auto tile(const ndarray_base<Xpr>& xpr, const inline_shape<>& reps) { return tiling<const Xpr&>{xpr.derived(), reps}; }
 
-// split
-// tile
+// lhs followed by rhs along an axis
+template
+< typename Lhs,
+  typename Rhs >
+auto concatenate(const ndarray_base<Lhs>& lhs, const ndarray_base<Rhs>& rhs, size_t axis = 0)
+{ return concatenation<const Lhs&, const Rhs&>{lhs.derived(), rhs.derived(), axis}; }
 
 } // namespace nd
 } // namespace ig
@@ -0,0 +1,499 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_NDARRAYREDUCTION_H
+#define IG_MATH_NDARRAYREDUCTION_H
+
+#include "imagine/math/theory/ndarray.h"
+
+#include <limits>
+
+namespace ig {
+namespace nd {
+
+// Reduction operators
+// combine works on scalars and, when the type has one, on simd packets
+struct sum_op {
+  template <typename T> static constexpr auto identity() { return T(0); }
+  template <typename T> static auto combine(const T& a, const T& b) { return a + b; }
+  template <typename T> static auto finish(T v, size_t) { return v; }
+};
+
+struct prod_op {
+  template <typename T> static constexpr auto identity() { return T(1); }
+  template <typename T> static auto combine(const T& a, const T& b) { return a * b; }
+  template <typename T> static auto finish(T v, size_t) { return v; }
+};
+
+struct min_op {
+  template <typename T> static constexpr auto identity() { return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max(); }
+  template <typename T> static auto combine(const T& a, const T& b) {
+    if constexpr (std::is_arithmetic_v<T>) return b < a ? b : a;
+    else
+      return min(a, b);
+  }
+  template <typename T> static auto finish(T v, size_t) { return v; }
+};
+
+struct max_op {
+  template <typename T> static constexpr auto identity() { return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest(); }
+  template <typename T> static auto combine(const T& a, const T& b) {
+    if constexpr (std::is_arithmetic_v<T>) return a < b ? b : a;
+    else
+      return max(a, b);
+  }
+  template <typename T> static auto finish(T v, size_t) { return v; }
+};
+
+struct mean_op : sum_op {
+  template <typename T> static auto finish(T v, size_t count) { return v / T(count); }
+};
+
+// index of the maximum, flattened over the reduced axes (first axis fastest), first occurrence on ties
+struct argmax_op {};
+
+// half precision elements are accumulated in float
+template <typename Op, typename T>
+struct reduction_result { using type = widened_t<T>; };
+template <typename T>
+struct reduction_result<argmax_op, T> { using type = size_t; };
+
+// Reduction layout
+// the source is collapsed into runs of adjacent dimensions sharing the same status (kept or reduced),
+// each run is contiguous in a dense source
+struct reduction_run { size_t size, stride, out; bool reduced; };
+
+template <typename Shape>
+auto reduction_runs(const Shape& shape, const std::vector<bool>& reduced) {
+  std::vector<reduction_run> runs;
+  size_t stride = 1, out = 1;
+  for (size_t d = 0; d < shape.size(); ++d) {
+    if (shape[d] == 1) continue;
+    if (!runs.empty() && runs.back().reduced == reduced[d]) runs.back().size *= shape[d];
+    else {
+      runs.push_back({shape[d], stride, reduced[d] ? 0 : out, reduced[d]});
+    }
+    stride *= shape[d];
+    if (!reduced[d]) out *= shape[d];
+  }
+  if (runs.empty()) runs.push_back({1, 1, 1, false});
+  return runs;
+}
+
+// walks every combination of the runs in order, fn(input offset, output offset, reduced index)
+template <typename Fn>
+void reduction_walk(const std::vector<reduction_run>& runs, Fn&& fn) {
+  std::vector<size_t> index(runs.size(), 0);
+  size_t in = 0, out = 0, red = 0;
+
+  // flattened index over the reduced runs, first run fastest
+  std::vector<size_t> weight(runs.size(), 0);
+  for (size_t r = 0, w = 1; r < runs.size(); ++r)
+    if (runs[r].reduced) {
+      weight[r] = w;
+      w *= runs[r].size;
+    }
+
+  for (;;) {
+    fn(in, out, red);
+    size_t r = 0;
+    for (; r < runs.size(); ++r) {
+      in  += runs[r].stride;
+      out += runs[r].out;
+      red += weight[r];
+      if (++index[r] < runs[r].size) break;
+      in  -= runs[r].stride * runs[r].size;
+      out -= runs[r].out * runs[r].size;
+      red -= weight[r] * runs[r].size;
+      index[r] = 0;
+    } if (r == runs.size()) return;
+  }
+}
+
+// Kernels
+// inner run kept -> output tiles accumulate whole source rows (vertical, packets over the tile)
+// inner run reduced -> each output reduces contiguous source runs (horizontal, packets folded at the end)
+constexpr size_t reduction_tile = 2048;
+
+template
+< typename Op,
+  typename T,
+  typename A >
+auto reduce_run(const T* src, size_t n, A acc) {
+  using packet = nd_packet<T>;
+  size_t i = 0;
+  if constexpr (same_packet<T, A>) {
+    if (n >= 2 * packet::width) {
+      auto p0 = packet::load(src), p1 = packet::load(src + packet::width);
+      for (i = 2 * packet::width; i + 2 * packet::width <= n; i += 2 * packet::width) {
+        p0 = Op::combine(p0, packet::load(src + i));
+        p1 = Op::combine(p1, packet::load(src + i + packet::width));
+      } p0 = Op::combine(p0, p1);
+
+      alignas(IG_VECTOR_SIMD) A lanes[packet::width];
+      nd_packet<A>::store(lanes, p0);
+      for (auto lane : lanes) acc = Op::combine(acc, lane);
+    }
+  }
+  for (; i < n; ++i) acc = Op::combine(acc, A(src[i]));
+  return acc;
+}
+
+template
+< typename Op,
+  typename A,
+  typename T >
+void reduce_rows(A* acc, const T* src, size_t n) {
+  using packet = nd_packet<A>;
+  size_t i = 0;
+  if constexpr (same_packet<T, A>) {
+    for (; i + packet::width <= n; i += packet::width)
+      packet::store(acc + i, Op::combine(packet::load(acc + i), nd_packet<T>::load(src + i)));
+  }
+  for (; i < n; ++i) acc[i] = Op::combine(acc[i], A(src[i]));
+}
+
+template
+< typename Op,
+  typename T,
+  typename R >
+void reduce_kernel(R* dst, const T* src, const std::vector<reduction_run>& runs, size_t count, const eval_policy& policy) {
+  using A = widened_t<T>;
+  auto& inner = runs[0];
+  auto outer = runs.size();
+  auto total = std::accumulate(runs.begin(), runs.end(), size_t(1), [](auto n, auto& r) { return n * r.size; });
+  auto threads = total < policy.threshold ? 1 : policy.threads;
+
+  auto parallel = [&](size_t n, size_t grain, auto&& fn) {
+    if (threads == 1) fn(size_t(0), n);
+    else
+      job::get().parallel_for(n, grain, fn, threads);
+  };
+
+  // kept and reduced runs past the inner one
+  std::vector<reduction_run> kept, reduced;
+  for (size_t r = 1; r < outer; ++r) (runs[r].reduced ? reduced : kept).push_back(runs[r]);
+  auto cells = std::accumulate(kept.begin(), kept.end(), size_t(1), [](auto n, auto& r) { return n * r.size; });
+
+  // starting offsets of a kept cell, decomposed from its flattened index
+  auto cell = [&](size_t c) {
+    size_t in = 0, out = 0;
+    for (auto& r : kept) {
+      in  += (c % r.size) * r.stride;
+      out += (c % r.size) * r.out;
+      c /= r.size;
+    } return std::pair{in, out};
+  };
+
+  if (!inner.reduced) {
+    auto tiles = (inner.size + reduction_tile - 1) / reduction_tile;
+
+    // a short inner run directly followed by a reduced one is widened over several of its rows,
+    // the segments of the wide accumulator are folded at the end
+    size_t wide = 1;
+    std::vector<reduction_run> rest = reduced;
+    if constexpr (!std::is_same_v<Op, argmax_op>) {
+      if (inner.size < reduction_tile / 8 && !reduced.empty() && reduced[0].stride == inner.size) {
+        wide = std::min(reduced[0].size, reduction_tile / inner.size);
+        rest.erase(rest.begin());
+      }
+    }
+
+    parallel(tiles * cells, 1, [&](size_t begin, size_t end) {
+      std::vector<A> acc(std::min(inner.size, reduction_tile) * wide);
+      std::vector<size_t> arg;
+      if constexpr (std::is_same_v<Op, argmax_op>) arg.resize(acc.size());
+
+      for (auto w = begin; w < end; ++w) {
+        auto [in, out] = cell(w / tiles);
+        auto t0 = (w % tiles) * reduction_tile;
+        auto tn = std::min(reduction_tile, inner.size - t0);
+
+        if constexpr (std::is_same_v<Op, argmax_op>) {
+          std::fill_n(acc.begin(), tn, max_op::identity<A>());
+          std::fill_n(arg.begin(), tn, 0);
+          reduction_walk(reduced, [&](auto roff, auto, auto red) {
+            auto row = src + in + roff + t0;
+            for (size_t i = 0; i < tn; ++i)
+              if (row[i] > acc[i]) {
+                acc[i] = row[i];
+                arg[i] = red;
+              }
+          });
+        } else if (wide > 1) {
+          std::fill(acc.begin(), acc.end(), Op::template identity<A>());
+          auto rows = reduced[0].size;
+          reduction_walk(rest, [&](auto roff, auto, auto) {
+            auto row = src + in + roff;
+            size_t k = 0;
+            for (; k + wide <= rows; k += wide) reduce_rows<Op>(acc.data(), row + k * tn, tn * wide);
+            reduce_rows<Op>(acc.data(), row + k * tn, tn * (rows - k));
+          });
+          for (size_t seg = 1; seg < wide; ++seg) reduce_rows<Op>(acc.data(), acc.data() + seg * tn, tn);
+        } else {
+          std::fill_n(acc.begin(), tn, Op::template identity<A>());
+          reduction_walk(reduced, [&](auto roff, auto, auto) { reduce_rows<Op>(acc.data(), src + in + roff + t0, tn); });
+        }
+
+        // the inner run is the fastest kept dimension, so output tiles are contiguous
+        for (size_t i = 0; i < tn; ++i) {
+          if constexpr (std::is_same_v<Op, argmax_op>) dst[out + t0 + i] = arg[i];
+          else
+            dst[out + t0 + i] = Op::finish(acc[i], count);
+        }
+      }
+    });
+  } else {
+    parallel(cells, std::max<size_t>(1, reduction_tile / inner.size), [&](size_t begin, size_t end) {
+      for (auto c = begin; c < end; ++c) {
+        auto [in, out] = cell(c);
+        if constexpr (std::is_same_v<Op, argmax_op>) {
+          auto best = max_op::identity<A>();
+          size_t arg = 0;
+          reduction_walk(reduced, [&](auto roff, auto, auto red) {
+            auto row = src + in + roff;
+            for (size_t i = 0; i < inner.size; ++i)
+              if (row[i] > best) {
+                best = row[i];
+                arg = red * inner.size + i;
+              }
+          });
+          dst[out] = arg;
+        } else {
+          auto acc = Op::template identity<A>();
+          reduction_walk(reduced, [&](auto roff, auto, auto) {
+            acc = reduce_run<Op>(src + in + roff, inner.size, acc);
+          });
+          dst[out] = Op::finish(acc, count);
+        }
+      }
+    });
+  }
+}
+
+// sparse sources fold their non-zeros only, outputs missing some of their elements also fold a zero
+template
+< typename Op,
+  typename R,
+  typename Arr >
+void reduce_sparse(R* dst, const Arr& src, const std::vector<bool>& reduced, size_t count, size_t size) {
+  using T = widened_t<ndarray_t<Arr>>;
+  auto& shape = src.shape();
+
+  // output and flattened reduced index of a source element
+  std::vector<size_t> out(shape.size(), 0), red(shape.size(), 0);
+  for (size_t d = 0, o = 1, r = 1; d < shape.size(); ++d) {
+    if (reduced[d]) red[d] = r, r *= shape[d];
+    else
+      out[d] = o, o *= shape[d];
+  }
+  auto locate = [&](size_t id) {
+    size_t o = 0, r = 0;
+    for (size_t d = 0; d < shape.size(); id /= shape[d++]) {
+      o += (id % shape[d]) * out[d];
+      r += (id % shape[d]) * red[d];
+    } return std::pair{o, r};
+  };
+
+  std::vector<size_t> hits(size, 0);
+  if constexpr (std::is_same_v<Op, argmax_op>) {
+    std::vector<T> best(size, max_op::identity<T>());
+    std::fill_n(dst, size, 0);
+    src->for_each([&](auto id, auto v) {
+      auto [o, r] = locate(id);
+      ++hits[o];
+      if (v > best[o] || (v == best[o] && r < dst[o])) {
+        best[o] = v;
+        dst[o] = r;
+      }
+    });
+
+    // outputs whose maximum is not above zero point at their first missing element when it comes first
+    std::vector< std::vector<size_t> > present(size);
+    src->for_each([&](auto id, auto) {
+      auto [o, r] = locate(id);
+      if (hits[o] < count && !(best[o] > T(0))) present[o].push_back(r);
+    });
+    for (size_t o = 0; o < size; ++o) {
+      if (hits[o] == count || best[o] > T(0)) continue;
+      auto& rs = present[o];
+      std::sort(rs.begin(), rs.end());
+      size_t gap = 0;
+      while (gap < rs.size() && rs[gap] == gap) ++gap;
+      if (best[o] < T(0) || gap < dst[o]) dst[o] = gap;
+    }
+  } else {
+    std::vector<T> acc(size, Op::template identity<T>());
+    src->for_each([&](auto id, auto v) {
+      auto o = locate(id).first;
+      ++hits[o];
+      acc[o] = Op::combine(acc[o], v);
+    });
+    for (size_t o = 0; o < size; ++o) {
+      if (hits[o] < count) acc[o] = Op::combine(acc[o], T(0));
+      dst[o] = Op::finish(acc[o], count);
+    }
+  }
+}
+
+} // namespace nd
+
+template <typename Op, typename Xpr>
+struct ndarray_traits
+<
+  reduction<Op, Xpr>
+>
+{
+  using value_type = typename nd::reduction_result< Op, std::remove_cv_t<ndarray_t<Xpr>> >::type;
+};
+
+// Reduction expression
+// lazy over the remaining dimensions, random access reduces on demand
+// while assignment runs the blocked kernels over a dense source (expressions are materialized first)
+template
+< typename o_,
+  typename x_ >
+class reduction : public ndarray_base< reduction<o_, x_> > {
+public:
+  using value_type  = ndarray_t<reduction>;
+  using source_type = std::remove_cv_t<ndarray_t<x_>>;
+
+  explicit reduction(x_ xpr, const nd::axes& axes)
+    : xpr_{xpr}
+    , reduced_(xpr.dims(), false)
+    , count_{1} {
+
+    for (auto axis : axes.v) {
+      if (axis >= xpr_.dims())
+        throw std::runtime_error{"[Ndarray] Reduction axis " + std::to_string(axis) + " out of range"};
+      reduced_[axis] = true;
+    }
+
+    for (size_t d = 0; d < xpr_.dims(); ++d) {
+      if (reduced_[d]) count_ *= xpr_.shape()[d];
+      else
+        shape_.push_back(xpr_.shape()[d]);
+    }
+    if (shape_.empty()) shape_.push_back(1);
+
+    strides_.resize(shape_.size());
+    size_ = 1;
+    for (size_t d = 0; d < shape_.size(); ++d) {
+      strides_[d] = size_;
+      size_ *= shape_[d];
+    }
+  }
+
+  auto size() const { return size_; }
+  auto dims() const { return shape_.size(); }
+  auto& shape() const   { return shape_; }
+  auto& strides() const { return strides_; }
+
+  template <typename... Id>
+  auto operator()(Id... ids) const {
+    size_t is[] = {size_t(ids)...};
+    return eval(std::inner_product(std::begin(is), std::end(is), strides_.begin(), size_t(0)));
+  }
+
+  // reduces the source elements of one output, in source linear order
+  auto eval(size_t id) const {
+    std::vector<reduction_index> walk;
+    size_t base = 0;
+    for (size_t d = 0, stride = 1; d < xpr_.dims(); stride *= xpr_.shape()[d++]) {
+      if (reduced_[d]) walk.push_back({xpr_.shape()[d], stride});
+      else {
+        base += (id % xpr_.shape()[d]) * stride;
+        id /= xpr_.shape()[d];
+      }
+    }
+
+    std::vector<size_t> index(walk.size(), 0);
+    size_t at = 0, red = 0;
+    auto acc = init();
+    auto best = nd::max_op::identity< widened_t<source_type> >();
+    for (;;) {
+      auto v = xpr_.eval(base + at);
+      if constexpr (std::is_same_v<o_, nd::argmax_op>) {
+        if (v > best) {
+          best = v;
+          acc = red;
+        }
+      } else
+        acc = o_::combine(acc, widened_t<source_type>(v));
+
+      ++red;
+      size_t w = 0;
+      for (; w < walk.size(); ++w) {
+        at += walk[w].stride;
+        if (++index[w] < walk[w].size) break;
+        at -= walk[w].stride * walk[w].size;
+        index[w] = 0;
+      } if (w == walk.size()) break;
+    }
+
+    if constexpr (std::is_same_v<o_, nd::argmax_op>) return acc;
+    else
+      return o_::finish(acc, count_);
+  }
+
+  static constexpr bool direct = true;
+
+  template <typename T>
+  void eval_into(T* dst, const nd::eval_policy& policy) const {
+    auto runs = nd::reduction_runs(xpr_.shape(), reduced_);
+    if constexpr (is_dense_leaf< std::decay_t<x_> >::value) nd::reduce_kernel<o_>(dst, xpr_.data(), runs, count_, policy);
+    else if constexpr (is_sparse_leaf< std::decay_t<x_> >::value) nd::reduce_sparse<o_>(dst, xpr_, reduced_, count_, size_);
+    else {
+      ndarray<source_type> src{xpr_.shape()};
+      src.assign(xpr_, policy);
+      nd::reduce_kernel<o_>(dst, src.data(), runs, count_, policy);
+    }
+  }
+
+private:
+  struct reduction_index { size_t size, stride; };
+
+  auto init() const {
+    if constexpr (std::is_same_v<o_, nd::argmax_op>) return size_t(0);
+    else
+      return o_::template identity< widened_t<source_type> >();
+  }
+
+  x_ xpr_;
+  std::vector<bool> reduced_;
+  nd::inline_shape<> shape_, strides_;
+  size_t size_, count_;
+};
+
+// whole array, dense, blocked (zero padded) and sparse arrays reduce their buffer directly
+template <typename D>
+auto ndarray_base<D>::sum() const -> widened_t<value_type> {
+  if constexpr (is_dense_leaf<D>::value) return nd::reduce_run<nd::sum_op>(derived().data(), size(), widened_t<value_type>(0));
+  else if constexpr (is_blocked_leaf<D>::value) return nd::reduce_run<nd::sum_op>(derived().data(), derived()->capacity(), widened_t<value_type>(0));
+  else if constexpr (is_sparse_leaf<D>::value) return nd::reduce_run<nd::sum_op>(derived()->values(), derived()->nnz(), widened_t<value_type>(0));
+  else
+    return std::accumulate(begin(), end(), widened_t<value_type>(0));
+}
+
+template <typename D>
+auto ndarray_base<D>::prod() const -> widened_t<value_type> {
+  if constexpr (is_dense_leaf<D>::value) return nd::reduce_run<nd::prod_op>(derived().data(), size(), widened_t<value_type>(1));
+  else if constexpr (is_sparse_leaf<D>::value) 
+    return derived()->nnz() < size() ? widened_t<value_type>(0) : nd::reduce_run<nd::prod_op>(derived()->values(), size(), widened_t<value_type>(1));
+  else
+    return std::accumulate(begin(), end(), widened_t<value_type>(1), std::multiplies<>{});
+}
+
+template <typename D> auto ndarray_base<D>::sum(const nd::axes& axes) const    { return reduction< nd::sum_op,    const D& >{derived(), axes}; }
+template <typename D> auto ndarray_base<D>::prod(const nd::axes& axes) const   { return reduction< nd::prod_op,   const D& >{derived(), axes}; }
+template <typename D> auto ndarray_base<D>::min(const nd::axes& axes) const    { return reduction< nd::min_op,    const D& >{derived(), axes}; }
+template <typename D> auto ndarray_base<D>::max(const nd::axes& axes) const    { return reduction< nd::max_op,    const D& >{derived(), axes}; }
+template <typename D> auto ndarray_base<D>::mean(const nd::axes& axes) const   { return reduction< nd::mean_op,   const D& >{derived(), axes}; }
+template <typename D> auto ndarray_base<D>::argmax(const nd::axes& axes) const { return reduction< nd::argmax_op, const D& >{derived(), axes}; }
+
+} // namespace ig
+
+#endif // IG_MATH_NDARRAYREDUCTION_H
@@ -0,0 +1,330 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_NDARRAYSTENCIL_H
+#define IG_MATH_NDARRAYSTENCIL_H
+
+#include "imagine/math/theory/ndarray.h"
+
+#include <limits>
+
+namespace ig {
+namespace nd {
+
+// Boundary policies
+// clamp -> edge elements are repeated
+// wrap  -> the array is periodic
+// zero  -> elements outside read zero
+enum class boundary { clamp, wrap, zero };
+
+// position along an extent n of the element read at i, n when it reads zero
+inline size_t boundary_index(ptrdiff_t i, size_t n, boundary b) {
+  auto e = ptrdiff_t(n);
+  if (i >= 0 && i < e) return size_t(i);
+  switch (b) {
+    case boundary::clamp: return i < 0 ? 0 : n - 1;
+    case boundary::wrap:  return size_t((i % e + e) % e);
+    default:              return n;
+  }
+}
+
+// weights type of stencils, integer elements (e.g. images) are weighted in float and rounded back with saturation
+template <typename T> using stencil_t = std::conditional_t<std::is_floating_point_v<T>, T, float>;
+
+template <typename T, typename A>
+auto stencil_cast(A v) {
+  if constexpr (std::is_integral_v<T>)
+    return static_cast<T>(std::clamp<A>(std::round(v), A(std::numeric_limits<T>::lowest()), A(std::numeric_limits<T>::max())));
+  else
+    return static_cast<T>(v);
+}
+
+// out[j] (+)= sum_t weights[t] * rows[t][j] for j < length, over packets when rows load as packets of the weights type
+template
+< typename A,
+  typename In >
+void stencil_rows(A* out, const In* const* rows, const A* weights, size_t taps, size_t length, bool accumulate) {
+  size_t j = 0;
+  if constexpr (same_packet<In, A>) {
+    using packet = nd_packet<A>;
+    for (; j + packet::width <= length; j += packet::width) {
+      auto acc = accumulate ? packet::load(out + j) : packet_t<A>(A(0));
+      for (size_t t = 0; t < taps; ++t) acc = acc + packet_t<A>(weights[t]) * nd_packet<In>::load(rows[t] + j);
+      packet::store(out + j, acc);
+    }
+  }
+  for (; j < length; ++j) {
+    auto acc = accumulate ? out[j] : A(0);
+    for (size_t t = 0; t < taps; ++t) acc += weights[t] * A(rows[t][j]);
+    out[j] = acc;
+  }
+}
+
+// taps of a boundary position, those reading zero are dropped
+template
+< typename A,
+  typename In >
+struct stencil_scratch {
+  explicit stencil_scratch(size_t taps) : rows(taps), weights(taps) {}
+  std::vector<const In*> rows;
+  std::vector<A> weights;
+};
+
+// one dimension of a stencil over a line of n positions of s contiguous elements each,
+// out[x * s + j] (+)= sum_t weights[t] * in[bnd(x + t - center) * s + j] for the elements [begin, end) of the line,
+// positions whose taps all fall inside are swept at once, the others are resolved row by row
+template
+< typename A,
+  typename In >
+void stencil_line(
+  A* out,
+  const In* in,
+  size_t n,
+  size_t s,
+  const A* weights,
+  size_t taps,
+  size_t center,
+  boundary b,
+  bool accumulate,
+  size_t begin,
+  size_t end,
+  stencil_scratch<A, In>& scratch) {
+
+  auto lo = std::min(center, n);
+  auto hi = n + center + 1 > taps ? std::max(lo, n + center + 1 - taps) : lo;
+  auto rows = scratch.rows.data();
+
+  for (auto x = begin / s; x * s < end; ++x) {
+    auto rb = std::max(begin, x * s);
+    if (x >= lo && x < hi) {
+      auto re = std::min(end, hi * s);
+      for (size_t t = 0; t < taps; ++t) rows[t] = in + (rb + t * s - center * s);
+      stencil_rows(out + rb, rows, weights, taps, re - rb, accumulate);
+      x = (re + s - 1) / s - 1;
+    } else {
+      auto re = std::min(end, (x + 1) * s);
+      size_t k = 0;
+      for (size_t t = 0; t < taps; ++t) {
+        auto i = boundary_index(ptrdiff_t(x + t) - ptrdiff_t(center), n, b);
+        if (i == n) continue;
+        rows[k] = in + i * s + (rb - x * s);
+        scratch.weights[k++] = weights[t];
+      } stencil_rows(out + rb, rows, scratch.weights.data(), k, re - rb, accumulate);
+    }
+  }
+}
+
+// Stencils
+// weights over a box of taps (first dimension fastest) centered on extent / 2, applied over the trailing
+// dimensions of arrays, leading ones are filtered independently (channels of {channels, width, height} images),
+// rank-one kernels are detected and applied as a product of one-dimensional passes
+template <typename A>
+class stencil {
+public:
+  template <typename K>
+  explicit stencil(const ndarray_base<K>& kernel, bool flip = false);
+
+  auto dims() const { return shape_.size(); }
+  auto& shape() const { return shape_; }
+  bool separable() const { return !factors_.empty(); }
+
+  template <typename Src>
+  auto operator()(const ndarray_base<Src>& src, boundary b = boundary::clamp, const eval_policy& policy = nd::policy()) const;
+
+private:
+  struct layout {
+    size_t inner, size;
+    inline_shape<> extents, strides;
+  };
+
+  template <typename In>
+  void sweep(A* out, const In* in, const layout& l, size_t d, const A* weights, boundary b, const eval_policy& policy) const;
+  template <typename In>
+  void direct(A* out, const In* in, const layout& l, boundary b, const eval_policy& policy) const;
+
+  inline_shape<> shape_;
+  std::vector<A> weights_;
+  std::vector< std::vector<A> > factors_;
+};
+
+template <typename A>
+template <typename K>
+stencil<A>::stencil(const ndarray_base<K>& kernel, bool flip) : shape_{kernel.shape().begin(), kernel.shape().end()} {
+  ndarray< std::remove_cv_t< ndarray_t<K> > > k{kernel};
+  weights_.assign(k.data(), k.data() + k.size());
+  if (flip) std::reverse(weights_.begin(), weights_.end());
+
+  // rank-one detection, factors are read through the largest tap and checked against every weight
+  auto pivot = size_t(std::max_element(weights_.begin(), weights_.end(), [](auto a, auto b) { return std::abs(a) < std::abs(b); }) - weights_.begin());
+  auto top = weights_.empty() ? A(0) : weights_[pivot];
+  if (top == A(0)) return;
+
+  std::vector< std::vector<A> > factors(dims());
+  for (size_t d = 0, stride = 1, rest = pivot; d < dims(); stride *= shape_[d++]) {
+    auto p = rest % shape_[d];
+    rest /= shape_[d];
+    for (size_t i = 0; i < shape_[d]; ++i) factors[d].push_back(weights_[pivot + i * stride - p * stride]);
+  }
+  for (auto& w : factors[0]) w /= std::pow(top, A(dims() - 1));
+
+  auto tolerance = std::abs(top) * std::numeric_limits<A>::epsilon() * 64;
+  for (size_t id = 0; id < weights_.size(); ++id) {
+    A w = 1;
+    for (size_t d = 0, rest = id; d < dims(); rest /= shape_[d++]) w *= factors[d][rest % shape_[d]];
+    if (std::abs(w - weights_[id]) > tolerance) return;
+  } factors_ = std::move(factors);
+}
+
+// one pass of a separable stencil along the spatial dimension d, split by lines and pieces of lines
+template <typename A>
+template <typename In>
+void stencil<A>::sweep(A* out, const In* in, const layout& l, size_t d, const A* weights, boundary b, const eval_policy& policy) const {
+  auto n = l.extents[d], s = l.strides[d];
+  auto line = n * s, lines = l.size / line;
+  auto piece = align(std::max(policy.chunk / sizeof(A), nd_packet<A>::width), nd_packet<A>::width);
+  auto pieces = (line + piece - 1) / piece;
+
+  auto walk = [&](size_t begin, size_t end) {
+    stencil_scratch<A, In> scratch{shape_[d]};
+    for (auto u = begin; u < end; ++u) {
+      auto offset = (u / pieces) * line, p = (u % pieces) * piece;
+      stencil_line(out + offset, in + offset, n, s, weights, shape_[d], shape_[d] / 2, b, false, p, std::min(line, p + piece), scratch);
+    }
+  };
+
+  auto threads = l.size < policy.threshold ? 1 : policy.threads;
+  if (threads == 1) walk(0, lines * pieces);
+  else
+    job::get().parallel_for(lines * pieces, 1, walk, threads);
+}
+
+// stencils through their first spatial dimension, each output line gathers the source lines reached by
+// the remaining taps, general kernels sweep every gathered line with its row of weights while separable
+// ones first combine the gathered lines into a line buffer and sweep it once
+template <typename A>
+template <typename In>
+void stencil<A>::direct(A* out, const In* in, const layout& l, boundary b, const eval_policy& policy) const {
+  auto k = dims();
+  auto n = l.extents[0], s = l.strides[0];
+  auto line = n * s, lines = l.size / line;
+  auto rows = weights_.size() / shape_[0];
+  auto fused = separable() && k > 1;
+
+  auto walk = [&](size_t begin, size_t end) {
+    stencil_scratch<A, In> gathered{rows}, scratch{shape_[0]};
+    stencil_scratch<A, A> combined{shape_[0]};
+    std::vector<A> buffer(fused ? line : 0);
+
+    for (auto u = begin; u < end; ++u) {
+      auto dst = out + u * line;
+      size_t count = 0;
+      for (size_t r = 0; r < rows; ++r) {
+        size_t offset = 0;
+        bool zero = false;
+        A w = 1;
+        for (size_t d = 1, y = u, o = r; d < k; ++d) {
+          auto i = boundary_index(ptrdiff_t(y % l.extents[d] + o % shape_[d]) - ptrdiff_t(shape_[d] / 2), l.extents[d], b);
+          zero |= i == l.extents[d];
+          offset += i * l.strides[d];
+          if (fused) w *= factors_[d][o % shape_[d]];
+          y /= l.extents[d];
+          o /= shape_[d];
+        }
+        if (zero) continue;
+        if (fused) {
+          gathered.rows[count] = in + offset;
+          gathered.weights[count++] = w;
+        } else {
+          stencil_line(dst, in + offset, n, s, weights_.data() + r * shape_[0], shape_[0], shape_[0] / 2, b, count++ > 0, 0, line, scratch);
+        }
+      }
+
+      if (!count) std::fill_n(dst, line, A(0));
+      else if (fused) {
+        stencil_rows(buffer.data(), gathered.rows.data(), gathered.weights.data(), count, line, false);
+        stencil_line(dst, static_cast<const A*>(buffer.data()), n, s, factors_[0].data(), shape_[0], shape_[0] / 2, b, false, 0, line, combined);
+      }
+    }
+  };
+
+  auto threads = l.size < policy.threshold ? 1 : policy.threads;
+  if (threads == 1) walk(0, lines);
+  else
+    job::get().parallel_for(lines, 1, walk, threads);
+}
+
+template <typename A>
+template <typename Src>
+auto stencil<A>::operator()(const ndarray_base<Src>& src, boundary b, const eval_policy& policy) const {
+  using value_type = std::remove_cv_t< ndarray_t<Src> >;
+  assert(src.dims() >= dims() && "Stencil of higher rank than the array");
+
+  ndarray<value_type> result{src.shape()};
+  auto lead = src.dims() - dims();
+  layout l{1, src.size(), {}, {}};
+  for (size_t d = 0; d < lead; ++d) l.inner *= src.shape()[d];
+  for (size_t d = 0, stride = l.inner; d < dims(); stride *= src.shape()[lead + d++]) {
+    l.extents.push_back(src.shape()[lead + d]);
+    l.strides.push_back(stride);
+  }
+  if (!l.size) return result;
+
+  // separable kernels over more than two dimensions run one pass per dimension alternating between two
+  // buffers, the last pass writes the result when it holds the weights type
+  auto run = [&](const value_type* in) {
+    std::vector<A> converted, buffers[2];
+    A* final = nullptr;
+    if constexpr (std::is_same_v<A, value_type>) final = result.data();
+    else {
+      converted.resize(l.size);
+      final = converted.data();
+    }
+
+    if (!separable() || dims() <= 2) direct(final, in, l, b, policy);
+    else {
+      const A* prev = nullptr;
+      for (size_t d = 0; d < dims(); ++d) {
+        auto dst = final;
+        if (d + 1 < dims()) {
+          buffers[d % 2].resize(l.size);
+          dst = buffers[d % 2].data();
+        }
+        if (!d) sweep(dst, in, l, d, factors_[d].data(), b, policy);
+        else
+          sweep(dst, prev, l, d, factors_[d].data(), b, policy);
+        prev = dst;
+      }
+    }
+
+    if constexpr (std::is_same_v<A, widened_t<value_type>> && !std::is_same_v<A, value_type>) convert_n(converted.data(), l.size, result.data());
+    else if constexpr (!std::is_same_v<A, value_type>)
+      std::transform(converted.begin(), converted.end(), result.data(), [](auto v) { return stencil_cast<value_type>(v); });
+  };
+
+  // dense sources are read in place, expressions are materialized first
+  if constexpr (is_dense_leaf<Src>::value) run(src.derived().data());
+  else
+    run(ndarray<value_type>{src}.data());
+  return result;
+}
+
+// convolution (flipped kernel) and correlation of the trailing dimensions of an array
+template
+< typename Src,
+  typename K >
+auto convolve(const ndarray_base<Src>& src, const ndarray_base<K>& kernel, boundary b = boundary::clamp, const eval_policy& policy = nd::policy())
+{ return stencil< stencil_t< std::remove_cv_t< ndarray_t<Src> > > >{kernel, true}(src, b, policy); }
+
+template
+< typename Src,
+  typename K >
+auto correlate(const ndarray_base<Src>& src, const ndarray_base<K>& kernel, boundary b = boundary::clamp, const eval_policy& policy = nd::policy())
+{ return stencil< stencil_t< std::remove_cv_t< ndarray_t<Src> > > >{kernel, false}(src, b, policy); }
+
+} // namespace nd
+} // namespace ig
+
+#endif // IG_MATH_NDARRAYSTENCIL_H
@@ -0,0 +1,346 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_NDARRAYBLOCKED_H
+#define IG_MATH_NDARRAYBLOCKED_H
+
+#include "imagine/math/theory/detail/ndarray/base.h"
+#include "imagine/math/theory/detail/ndarray/allocator/dense.h"
+
+namespace ig {
+namespace nd {
+
+// Block orders
+// place of every element in the buffer, separable over the dimensions (the offset of (i0, i1, ...) is the sum
+// of offset(d, i_d) over d, offsets(d) being the table of dimension d), walk(begin, end, strides, fn) visits
+// the units [begin, end) of the buffer in storage order by runs fn(offset, linear index, length) contiguous in both,
+// long runs (whole rows of bricks) make it the fastest traversal for assignments as well
+
+// bricks of Edge elements along each dimension (the extent when smaller), stored one after the other with
+// their elements and the bricks themselves following the first dimension fastest, far bricks are padded
+template <size_t Edge = 16>
+class tiled_order {
+public:
+  static_assert(Edge > 0, "Empty bricks");
+  static constexpr bool long_runs = true;
+
+  tiled_order() = default;
+  template <typename Shape>
+  explicit tiled_order(const Shape& shape);
+
+  auto capacity() const { return units_ * brick_; }
+  auto units() const { return units_; }
+  auto unit() const { return brick_; }
+  auto offset(size_t d, size_t i) const { return table_[base_[d] + i]; }
+  auto offsets(size_t d) const { return table_.data() + base_[d]; }
+
+  template <typename Fn>
+  void walk(size_t begin, size_t end, const inline_shape<>& strides, Fn&& fn) const;
+
+private:
+  inline_shape<> shape_, edges_, counts_, inner_, base_;
+  std::vector<size_t> table_;
+  size_t brick_ = 1, units_ = 0;
+};
+
+template <size_t Edge>
+template <typename Shape>
+tiled_order<Edge>::tiled_order(const Shape& shape) : shape_{shape.begin(), shape.end()}, units_{1} {
+  for (auto n : shape_) {
+    auto e = std::max<size_t>(1, std::min(Edge, n));
+    edges_.push_back(e);
+    counts_.push_back((n + e - 1) / e);
+    inner_.push_back(brick_);
+    brick_  *= e;
+    units_  *= counts_.back();
+  }
+
+  for (size_t d = 0, outer = brick_; d < shape_.size(); outer *= counts_[d++]) {
+    base_.push_back(table_.size());
+    for (size_t i = 0; i < shape_[d]; ++i) table_.push_back(i / edges_[d] * outer + i % edges_[d] * inner_[d]);
+  }
+}
+
+// rows of each brick, clipped to the array
+template <size_t Edge>
+template <typename Fn>
+void tiled_order<Edge>::walk(size_t begin, size_t end, const inline_shape<>& strides, Fn&& fn) const {
+  auto k = shape_.size();
+  inline_shape<> extent(k), index(k);
+  for (auto u = begin; u < end; ++u) {
+    auto offset = u * brick_;
+    size_t id = 0;
+    for (size_t d = 0, p = u; d < k; ++d) {
+      auto origin = p % counts_[d] * edges_[d];
+      p /= counts_[d];
+      extent[d] = std::min(edges_[d], shape_[d] - origin);
+      id += origin * strides[d];
+    }
+
+    std::fill(index.begin(), index.end(), 0);
+    for (;;) {
+      fn(offset, id, extent[0]);
+      size_t d = 1;
+      for (; d < k; ++d) {
+        offset += inner_[d];
+        id     += strides[d];
+        if (++index[d] < extent[d]) break;
+        offset -= inner_[d] * extent[d];
+        id     -= strides[d] * extent[d];
+        index[d] = 0;
+      } if (d == k) break;
+    }
+  }
+}
+
+// Z-order curve, the coordinate bits are interleaved level by level from the lowest (first dimension first)
+// while each extent has bits left, so that extents are padded to a power of two independently,
+// units are aligned runs of unit() codes
+class morton_order {
+public:
+  static constexpr bool long_runs = false;
+
+  morton_order() = default;
+  template <typename Shape>
+  explicit morton_order(const Shape& shape);
+
+  auto capacity() const { return capacity_; }
+  auto units() const { return (capacity_ + unit_ - 1) / unit_; }
+  auto unit() const { return unit_; }
+  auto offset(size_t d, size_t i) const { return table_[base_[d] + i]; }
+  auto offsets(size_t d) const { return table_.data() + base_[d]; }
+
+  template <typename Fn>
+  void walk(size_t begin, size_t end, const inline_shape<>& strides, Fn&& fn) const;
+
+private:
+  static constexpr size_t unit_bits = 12;
+
+  inline_shape<> shape_, base_;
+  std::vector<size_t> table_;
+  std::vector<size_t> dim_, weight_;
+  size_t capacity_ = 0, unit_ = 1;
+};
+
+template <typename Shape>
+morton_order::morton_order(const Shape& shape) : shape_{shape.begin(), shape.end()} {
+  auto k = shape_.size();
+  inline_shape<> bits(k, 0);
+  for (size_t d = 0; d < k; ++d) while ((size_t(1) << bits[d]) < shape_[d]) ++bits[d];
+
+  // code bit of each coordinate bit
+  std::vector< std::vector<size_t> > position(k);
+  auto levels = k ? *std::max_element(bits.begin(), bits.end()) : 0;
+  for (size_t l = 0; l < levels; ++l)
+    for (size_t d = 0; d < k; ++d)
+      if (l < bits[d]) {
+        position[d].push_back(dim_.size());
+        dim_.push_back(d);
+        weight_.push_back(size_t(1) << l);
+      }
+
+  for (size_t d = 0; d < k; ++d) {
+    base_.push_back(table_.size());
+    for (size_t i = 0; i < shape_[d]; ++i) {
+      size_t code = 0;
+      for (size_t l = 0; l < bits[d]; ++l) code |= (i >> l & 1) << position[d][l];
+      table_.push_back(code);
+    }
+  }
+
+  auto empty = std::find(shape_.begin(), shape_.end(), 0) != shape_.end();
+  capacity_ = empty ? 0 : size_t(1) << dim_.size();
+  unit_ = size_t(1) << std::min(dim_.size(), unit_bits);
+}
+
+// codes are incremented one by one, the coordinate bits flipped by the carry update the position,
+// padding codes are skipped and consecutive elements along the first dimension are merged in runs
+template <typename Fn>
+void morton_order::walk(size_t begin, size_t end, const inline_shape<>& strides, Fn&& fn) const {
+  auto k = shape_.size();
+  auto code = begin * unit_, last = std::min(end * unit_, capacity_);
+  if (code >= last) return;
+
+  inline_shape<> x(k, 0);
+  size_t id = 0;
+  for (size_t b = 0; b < dim_.size(); ++b)
+    if (code >> b & 1) {
+      x[dim_[b]] += weight_[b];
+      id += weight_[b] * strides[dim_[b]];
+    }
+
+  size_t run = 0, from = 0, first = 0;
+  for (;;) {
+    bool inside = true;
+    for (size_t d = 0; d < k; ++d) inside &= x[d] < shape_[d];
+    if (inside) {
+      if (run && code == from + run && id == first + run) ++run;
+      else {
+        if (run) fn(from, first, run);
+        from  = code;
+        first = id;
+        run   = 1;
+      }
+    }
+
+    if (++code == last) break;
+    auto carry = size_t(__builtin_ctzll(code));
+    for (size_t b = 0; b < carry; ++b) {
+      x[dim_[b]] -= weight_[b];
+      id -= weight_[b] * strides[dim_[b]];
+    }
+    x[dim_[carry]] += weight_[carry];
+    id += weight_[carry] * strides[dim_[carry]];
+  }
+  if (run) fn(from, first, run);
+}
+
+// Blocked storage
+// dense elements placed in the buffer by a block order, linear indices keep following the dense layout
+// (first dimension fastest) so that blocked arrays evaluate like any other, padding elements stay zero,
+// for_each visits the elements in storage order, assignments and scatters into dense destinations run
+// over the job::get() workers either in storage order (orders with long runs) or by rows of the dense
+// layout placed through the offsets of the first dimension (curves)
+struct block_position { size_t offset; };
+
+template
+< typename T,
+  typename Order >
+class blocked {
+public:
+  using value_type = T;
+  using shape_type = inline_shape<>;
+  using order_type = Order;
+  static constexpr auto dynamic = true;
+
+  blocked() = default;
+  template <typename Shape>
+  explicit blocked(const Shape& dims)
+    : size_{linear_layout(shape_, strides_, dims)}
+    , order_{shape_}
+    , buffer_(order_.capacity(), value_type(0)) {}
+
+  auto dims() const { return shape_.size(); }
+  auto size() const { return size_; }
+  auto capacity() const { return buffer_.size(); }
+
+  auto buffer() const { return buffer_.data(); }
+  auto buffer()       { return buffer_.data(); }
+
+  decltype(auto) operator()(size_t n) const { return buffer_[locate(n)]; }
+  decltype(auto) operator()(size_t n)       { return buffer_[locate(n)]; }
+  decltype(auto) operator()(block_position p) const { return buffer_[p.offset]; }
+  decltype(auto) operator()(block_position p)       { return buffer_[p.offset]; }
+
+  auto operator[](size_t dimension) const
+  { return shape_[dimension]; }
+
+  template <typename... Id>
+  auto access(Id... ids) const {
+    assert(sizeof...(Id) == dims() && "Invalid ndarray subscript");
+    size_t offset = 0, d = 0;
+    ((offset += order_.offset(d++, size_t(ids))), ...);
+    return block_position{offset};
+  }
+
+  auto& shape() const   { return shape_; }
+  auto& strides() const { return strides_; }
+  auto& order() const   { return order_; }
+
+  // fn(linear index, element) over the elements, in storage order
+  template <typename Fn>
+  void for_each(Fn&& fn) const { order_.walk(0, order_.units(), strides_, [&](auto offset, auto id, auto n) { for (size_t j = 0; j < n; ++j) fn(id + j, buffer_[offset + j]); }); }
+  template <typename Fn>
+  void for_each(Fn&& fn)       { order_.walk(0, order_.units(), strides_, [&](auto offset, auto id, auto n) { for (size_t j = 0; j < n; ++j) fn(id + j, buffer_[offset + j]); }); }
+
+  // broadcasting right-hand sides are laid out densely first, runs shorter than a row would read them element by element
+  template <typename Xpr>
+  void assign(const Xpr& xpr, const eval_policy& policy) {
+    if (xpr.broadcasting()) return assign(basic_ndarray< dense< dynamic_alloc<T> > >{xpr}, policy);
+    if constexpr (Order::long_runs) runs([&](auto offset, auto id, auto n) { eval_span(buffer_.data() + offset, xpr, id, n); }, policy);
+    else {
+      auto lane = order_.offsets(0);
+      rows([&](auto id, auto base, auto line, auto length) {
+        eval_span(line, xpr, id, length);
+        for (size_t x = 0; x < length; ++x) buffer_[base + lane[x]] = line[x];
+      }, policy);
+    }
+  }
+
+  template <typename U>
+  void scatter(U* dst, const eval_policy& policy) const {
+    if constexpr (Order::long_runs) runs([&](auto offset, auto id, auto n) { std::copy_n(buffer_.data() + offset, n, dst + id); }, policy);
+    else {
+      auto lane = order_.offsets(0);
+      rows([&](auto id, auto base, auto, auto length) {
+        for (size_t x = 0; x < length; ++x) dst[id + x] = buffer_[base + lane[x]];
+      }, policy);
+    }
+  }
+
+private:
+  auto locate(size_t n) const {
+    size_t offset = 0;
+    for (size_t d = 0; d < shape_.size(); ++d) {
+      offset += order_.offset(d, n % shape_[d]);
+      n /= shape_[d];
+    } return offset;
+  }
+
+  // fn(offset, linear index, length) over the runs of every unit
+  template <typename Fn>
+  void runs(Fn&& fn, const eval_policy& policy) const {
+    auto walk = [&](size_t begin, size_t end) { order_.walk(begin, end, strides_, fn); };
+    auto threads = size_ < policy.threshold ? 1 : policy.threads;
+    if (threads == 1) walk(0, order_.units());
+    else
+      job::get().parallel_for(order_.units(), std::max<size_t>(1, policy.chunk / (sizeof(T) * order_.unit())), walk, threads);
+  }
+
+  // fn(linear index, buffer offset, line buffer, length) over the rows of the dense layout
+  template <typename Fn>
+  void rows(Fn&& fn, const eval_policy& policy) const {
+    if (!size_) return;
+    auto length = shape_[0], count = size_ / length;
+    auto walk = [&](size_t begin, size_t end) {
+      std::vector<value_type> line(length);
+      inline_shape<> index(dims(), 0);
+      size_t base = 0;
+      for (size_t d = 1, r = begin; d < dims(); ++d) {
+        index[d] = r % shape_[d];
+        r /= shape_[d];
+        base += order_.offset(d, index[d]);
+      }
+
+      for (auto r = begin; r < end; ++r) {
+        fn(r * length, base, line.data(), length);
+        for (size_t d = 1; d < dims(); ++d) {
+          base -= order_.offset(d, index[d]);
+          if (++index[d] < shape_[d]) {
+            base += order_.offset(d, index[d]);
+            break;
+          } index[d] = 0;
+        }
+      }
+    };
+
+    auto threads = size_ < policy.threshold ? 1 : policy.threads;
+    if (threads == 1) walk(0, count);
+    else
+      job::get().parallel_for(count, std::max<size_t>(1, policy.chunk / (sizeof(T) * length)), walk, threads);
+  }
+
+  shape_type shape_;
+  shape_type strides_;
+  size_t size_ = 0;
+  Order order_;
+  std::vector<value_type, aligned_allocator<value_type, cache_line, current_pages>> buffer_;
+};
+
+} // namespace nd
+} // namespace ig
+
+#endif // IG_MATH_NDARRAYBLOCKED_H
@@ -8,6 +8,9 @@
 #define IG_MATH_NDARRAYDENSE_H
 
 #include "imagine/math/basis.h"
+#include "imagine/math/theory/detail/ndarray/shape.h"
+#include "imagine/core/mem/resource.h"
+#include "imagine/core/mem/pages.h"
 #include <vector>
 #include <array>
 
@@ -20,8 +23,9 @@ public:
   using value_type     = typename Alloc::value_type;
   using shape_type     = typename Alloc::shape_type;
   using container_type = typename Alloc::container_type;
-  template <typename T, size_t... D> 
-  friend class ndarray;
+  static constexpr auto dynamic = Alloc::dynamic;
+  template <typename S> 
+  friend class basic_ndarray;
 
   template <typename... Args>
   explicit constexpr dense(Args&&... args) { Alloc::construct(shape_, strides_, buffer_, std::forward<Args>(args)...); }
@@ -45,6 +49,7 @@ public:
 
   auto& shape() const   { return shape_; }
   auto& strides() const { return strides_; }
+  auto& container() const { return buffer_; }
 
 private:
   shape_type shape_;
@@ -62,19 +67,74 @@ auto dense<Alloc>::access(Id i, Ids... is) const {
     C < dims() &&
     i < size() && "Invalid ndarray subscript");
 
+  // static strides are folded into the subscript
+  if constexpr (!dynamic) 
+    return
+      Alloc::extents_type::strides[C] * i +
+      access
+      <C + 1>
+        (is...);
+  else
+    return
+      strides_[C] * i +
+      access
+      <C + 1>
+        (is...);
+}
+
+template 
+< typename Shape, 
+  typename Dims >
+constexpr auto linear_layout(Shape& shape, Shape& strides, Dims&& dims) {
+  shape.assign(dims.begin(), dims.end());
+  strides.clear();
   return
-    strides_[C] * i +
-    access
-    <C + 1>
-      (is...);
+    std::accumulate(
+      shape.begin(),
+      shape.end(),
+      size_t(1),
+      [&](auto size, auto dim) 
+      { return strides.emplace_back(size) * dim; });
 }
 
 template <typename T>
 class dynamic_alloc {
 public:
   using value_type = T;
-  using shape_type     = std::vector<size_t>;
-  using container_type = std::vector<value_type>;
+  using shape_type     = inline_shape<>;
+  using container_type = std::vector<value_type, allocator<value_type>>;
+  static constexpr auto dynamic = true;
+
+  template <typename Shape>
+  static constexpr 
+  void construct(
+    shape_type& shape, 
+    shape_type& strides, 
+    container_type& buffer, 
+    Shape&& dims) {
+
+    buffer.resize(
+      linear_layout(
+        shape,
+        strides,
+        dims)
+      );
+  }
+};
+
+// cache-line aligned storage, elements are left uninitialized until evaluated (first touch)
+// large arrays can be backed by huge pages through transparent_pages or huge_pages
+constexpr size_t cache_line = 64;
+
+template 
+< typename T, 
+  typename Pages = current_pages >
+class aligned_alloc {
+public:
+  using value_type = T;
+  using shape_type     = inline_shape<>;
+  using container_type = std::vector<value_type, aligned_allocator<value_type, cache_line, Pages>>;
+  static constexpr auto dynamic = true;
 
   template <typename Shape>
   static constexpr 
@@ -84,24 +144,71 @@ public:
     container_type& buffer, 
     Shape&& dims) {
 
-    shape.assign(dims.begin(), dims.end());
     buffer.resize(
-      std::accumulate(
-        shape.begin(),
-        shape.end(),
-        1,
-        [&](auto size, auto dim) 
-        { return strides.emplace_back(size) * dim; })
+      linear_layout(
+        shape,
+        strides,
+        dims)
       );
   }
 };
 
+// non-owning buffer, the holder keeps the underlying memory alive
+template <typename T>
+class extern_buffer {
+public:
+  using value_type = T;
+
+  extern_buffer() = default;
+  explicit extern_buffer(T* data, size_t size, std::shared_ptr<const void> holder)
+    : data_{data}
+    , size_{size}
+    , holder_{std::move(holder)} {}
+
+  auto data() const { return static_cast<const T*>(data_); }
+  auto data()       { return data_; }
+  auto size() const { return size_; }
+
+  auto& operator[](size_t n) const { return data_[n]; }
+  auto& operator[](size_t n)       { return data_[n]; }
+
+private:
+  T* data_ = nullptr;
+  size_t size_ = 0;
+  std::shared_ptr<const void> holder_;
+};
+
+template <typename T>
+class extern_alloc {
+public:
+  using value_type = T;
+  using shape_type     = inline_shape<>;
+  using container_type = extern_buffer<value_type>;
+  static constexpr auto dynamic = true;
+
+  template <typename Shape>
+  static 
+  void construct(
+    shape_type& shape, 
+    shape_type& strides, 
+    container_type& buffer, 
+    Shape&& dims,
+    T* data,
+    std::shared_ptr<const void> holder = {}) {
+
+    auto size = linear_layout(shape, strides, dims);
+    buffer = container_type{data, size, std::move(holder)};
+  }
+};
+
 template <typename T, size_t... D>
 class static_alloc {
 public:
   using value_type = T;
   using shape_type     = std::array<size_t, sizeof...(D)>;
   using container_type = std::array<value_type, (D * ... * 1)>;
+  using extents_type   = extents<D...>;
+  static constexpr auto dynamic = false;
 
   template <typename... Args>
   static constexpr
@@ -111,15 +218,8 @@ public:
     container_type& buffer, 
     Args&&... values) {
 
-    shape = {D...};
-    strides[0] = 1;
-    std::transform(
-      shape.begin(),
-      shape.end() - 1,
-      strides.begin(),
-      strides.begin() + 1,
-      [](auto dim, auto stride) 
-      { return dim * stride; });
+    shape   = extents_type::shape;
+    strides = extents_type::strides;
     buffer = {{std::forward<Args>(values)...}};
   }
 };
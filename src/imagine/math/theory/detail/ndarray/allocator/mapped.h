@@ -0,0 +1,201 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_NDARRAYMAPPED_H
+#define IG_MATH_NDARRAYMAPPED_H
+
+#include "imagine/math/theory/detail/ndarray/expr/wise.h"
+#include "imagine/math/theory/detail/ndarray/allocator/dense.h"
+#include "imagine/core/mem/mapping.h"
+
+#include <cstring>
+#include <memory>
+
+namespace ig {
+namespace nd {
+
+// Array files
+// layout -> header | padding | elements in the dense layout (first dimension fastest), starting on a page
+constexpr uint32_t mapped_version = 1;
+constexpr size_t   mapped_offset  = 4096;
+constexpr size_t   mapped_dims    = max_dims;
+
+struct mapped_header {
+  char magic[4];
+  uint32_t version;
+  section_type type;
+  uint32_t element;
+  uint32_t dims;
+  uint32_t reserved;
+  uint64_t shape[mapped_dims];
+  uint64_t strides[mapped_dims];
+  uint64_t offset;
+};
+
+// elements of a mapped array file, the mapping is shared by copies of the array
+template <typename T>
+class mapped_buffer {
+public:
+  using mode = mapping::mode;
+
+  mapped_buffer() = default;
+  explicit mapped_buffer(std::shared_ptr<mapping> map, size_t size, mode m)
+    : map_{std::move(map)}
+    , size_{size}
+    , mode_{m} {}
+
+  auto data() const { return reinterpret_cast<const T*>(map_->data() + mapped_offset); }
+  auto data()       { return reinterpret_cast<T*>(map_->data() + mapped_offset); }
+  auto size() const { return size_; }
+  auto access() const { return mode_; }
+
+  auto& operator[](size_t n) const { return data()[n]; }
+  auto& operator[](size_t n)       { return data()[n]; }
+
+  // hints over the elements [begin, end)
+  void advise(size_t begin, size_t end, mapping::access a) const { mapping::advise(data() + begin, (end - begin) * sizeof(T), a); }
+  void flush(size_t begin, size_t end, bool wait = false) const {
+    if (mode_ == mode::shared) mapping::flush(data() + begin, (end - begin) * sizeof(T), wait);
+  }
+
+private:
+  std::shared_ptr<mapping> map_;
+  size_t size_ = 0;
+  mode mode_ = mode::read;
+};
+
+// file-backed storage, the file is opened (read, cow or shared) or created (shared) with the given shape
+template <typename T>
+class mmap_alloc {
+public:
+  using value_type = T;
+  using shape_type     = inline_shape<>;
+  using container_type = mapped_buffer<value_type>;
+  static constexpr auto dynamic = true;
+
+  static
+  void construct(
+    shape_type& shape,
+    shape_type& strides,
+    container_type& buffer,
+    const std::string& path,
+    mapping::mode m = mapping::mode::read);
+
+  template <typename Shape, typename = std::enable_if_t< !std::is_convertible_v<Shape, mapping::mode> >>
+  static
+  void construct(
+    shape_type& shape,
+    shape_type& strides,
+    container_type& buffer,
+    const std::string& path,
+    const Shape& dims);
+};
+
+template <typename T>
+void mmap_alloc<T>::construct(shape_type& shape, shape_type& strides, container_type& buffer, const std::string& path, mapping::mode m) {
+  auto map = std::make_shared<mapping>(path, m);
+  mapped_header h{};
+  if (map->size() >= sizeof(h)) std::memcpy(&h, map->data(), sizeof(h));
+
+  auto invalid = [&](const std::string& why) { return std::runtime_error{"[Ndarray] Invalid array file " + path + " (" + why + ")"}; };
+  if (map->size() < mapped_offset || std::memcmp(h.magic, "IGND", 4) != 0 || h.version != mapped_version) throw invalid("not an array file");
+  if (h.element != sizeof(T) || (h.type != section_type::opaque && h.type != section_type_of<T>())) throw invalid("element type mismatch");
+  if (h.dims > mapped_dims || h.offset != mapped_offset) throw invalid("unsupported layout");
+
+  // the shape must fit in the mapped elements, checked by divisions so that products cannot wrap
+  auto available = (map->size() - mapped_offset) / sizeof(T);
+  if (std::find(h.shape, h.shape + h.dims, 0) == h.shape + h.dims) {
+    uint64_t n = 1;
+    for (size_t d = 0; d < h.dims; n *= h.shape[d++])
+      if (n > available / h.shape[d]) throw invalid("truncated elements");
+  }
+
+  auto size = linear_layout(shape, strides, inline_shape<>(h.shape, h.shape + h.dims));
+  if (!std::equal(strides.begin(), strides.end(), h.strides)) throw invalid("strides are not in the dense layout");
+  if (map->size() < mapped_offset + size * sizeof(T)) throw invalid("truncated elements");
+
+  // arrays are mostly traversed linearly, the kernel reads ahead and drops pages behind
+  buffer = container_type{std::move(map), size, m};
+  buffer.advise(0, size, mapping::access::sequential);
+}
+
+template <typename T>
+template <typename Shape, typename>
+void mmap_alloc<T>::construct(shape_type& shape, shape_type& strides, container_type& buffer, const std::string& path, const Shape& dims) {
+  if (dims.size() > mapped_dims)
+    throw std::runtime_error{"[Ndarray] Array file " + path + " exceeds " + std::to_string(mapped_dims) + " dimensions"};
+
+  auto size = linear_layout(shape, strides, dims);
+  auto map = std::make_shared<mapping>(path, mapping::mode::shared, mapped_offset + size * sizeof(T));
+
+  mapped_header h{};
+  std::memcpy(h.magic, "IGND", 4);
+  h.version = mapped_version;
+  h.type    = section_type_of<T>();
+  h.element = sizeof(T);
+  h.dims    = static_cast<uint32_t>(shape.size());
+  h.offset  = mapped_offset;
+  std::copy(shape.begin(), shape.end(), h.shape);
+  std::copy(strides.begin(), strides.end(), h.strides);
+  std::memcpy(map->data(), &h, sizeof(h));
+
+  buffer = container_type{std::move(map), size, mapping::mode::shared};
+  buffer.advise(0, size, mapping::access::sequential);
+}
+
+// Streaming
+// assignments into array files run by windows of stream_window bytes, the next window of the destination
+// and of the file-backed operands is prefetched while the current one is evaluated, written windows are
+// handed to write-back and read-only operands give their pages back
+constexpr size_t stream_window = size_t(64) << 20;
+
+template <typename Xpr, typename Fn>
+void for_each_mapped(const Xpr&, Fn&&) {}
+template <typename T, typename Fn>
+void for_each_mapped(const basic_ndarray< dense< mmap_alloc<T> > >& arr, Fn&& fn) { fn(arr->container()); }
+template <typename F, typename S, typename... X, typename Fn>
+void for_each_mapped(const wise<F, S, X...>& xpr, Fn&& fn)
+{ std::apply([&](auto&&... x) { (for_each_mapped(x, fn), ...); }, xpr.operands()); }
+
+template
+< typename Gen,
+  typename Xpr >
+void stream(Gen& ev, const Xpr& xpr, const eval_policy& policy) {
+  using value_type = ndarray_t<Gen>;
+  auto& out = ev->container();
+  if (out.access() == mapping::mode::read)
+    throw std::runtime_error{"[Ndarray] Assignment into a read-only array file"};
+
+  auto dst = ev.data();
+  auto n = xpr.size();
+  auto window = align(std::max(stream_window / sizeof(value_type), nd_packet<value_type>::width), nd_packet<value_type>::width);
+  auto threads = n < policy.threshold ? 1 : policy.threads;
+
+  for (size_t b = 0; b < n; b += window) {
+    auto e = std::min(n, b + window);
+    if (e < n) {
+      auto next = std::min(n, e + window);
+      out.advise(e, next, mapping::access::willneed);
+      for_each_mapped(xpr, [&](auto& src) { src.advise(e, next, mapping::access::willneed); });
+    }
+
+    if (threads == 1) eval_range(dst, xpr, b, e);
+    else
+      job::get().parallel_for(
+        e - b,
+        align(std::max(policy.chunk / sizeof(value_type), nd_packet<value_type>::width), nd_packet<value_type>::width),
+        [&](auto begin, auto end) { eval_range(dst, xpr, b + begin, b + end); },
+        threads);
+
+    out.flush(b, e);
+    for_each_mapped(xpr, [&](auto& src) { if (src.access() == mapping::mode::read) src.advise(b, e, mapping::access::dontneed); });
+  }
+}
+
+} // namespace nd
+} // namespace ig
+
+#endif // IG_MATH_NDARRAYMAPPED_H
@@ -8,12 +8,355 @@
 #define IG_MATH_NDARRAYSPARSE_H
 
 #include "imagine/math/basis.h"
+#include "imagine/math/theory/detail/ndarray/expr/wise.h"
+#include "imagine/math/theory/detail/ndarray/allocator/dense.h"
+
+#include <optional>
 #include <vector>
 
 namespace ig {
 namespace nd {
 
+// Sparse layout
+// logical shape of a sparse array, linear indices follow the dense layout (first dimension fastest)
+class sparse_layout {
+public:
+  using shape_type = inline_shape<>;
+  static constexpr auto dynamic = true;
+
+  sparse_layout() = default;
+  template <typename Shape>
+  explicit sparse_layout(const Shape& dims) : size_{linear_layout(shape_, strides_, dims)} {}
+
+  auto dims() const { return shape_.size(); }
+  auto size() const { return size_; }
+
+  auto operator[](size_t dimension) const
+  { return shape_[dimension]; }
+
+  template <typename... Id>
+  auto access(Id... ids) const {
+    assert(sizeof...(Id) == dims() && "Invalid ndarray subscript");
+    size_t id = 0, d = 0;
+    ((id += strides_[d++] * size_t(ids)), ...);
+    return id;
+  }
+
+  auto coordinate(size_t id, size_t dimension) const
+  { return id / strides_[dimension] % shape_[dimension]; }
+
+  auto& shape() const   { return shape_; }
+  auto& strides() const { return strides_; }
+
+protected:
+  shape_type shape_;
+  shape_type strides_;
+  size_t size_ = 0;
+};
+
+// Patterns
+// sorted linear indices where an expression may be non-zero, none when every element has to be evaluated
+using sparse_ids = std::optional< std::vector<size_t> >;
+
+// how an element-wise functor combines the patterns of its operands
+enum class sparse_rule { dense, first, merge, intersect };
+
+template <typename Fn> struct sparse_rule_of : std::integral_constant<sparse_rule, sparse_rule::dense> {};
+
+template <> struct sparse_rule_of< std::negate<> >     : std::integral_constant<sparse_rule, sparse_rule::first> {};
+template <> struct sparse_rule_of< std::divides<> >    : std::integral_constant<sparse_rule, sparse_rule::first> {};
+template <> struct sparse_rule_of< std::plus<> >       : std::integral_constant<sparse_rule, sparse_rule::merge> {};
+template <> struct sparse_rule_of< std::minus<> >      : std::integral_constant<sparse_rule, sparse_rule::merge> {};
+template <> struct sparse_rule_of< std::multiplies<> > : std::integral_constant<sparse_rule, sparse_rule::intersect> {};
+
+template <typename S, bool Left> struct sparse_rule_of< scalar_op<std::multiplies<>, S, Left> > : std::integral_constant<sparse_rule, sparse_rule::first> {};
+template <typename S>            struct sparse_rule_of< scalar_op<std::divides<>,    S, false> > : std::integral_constant<sparse_rule, sparse_rule::first> {};
+
+template <typename Xpr>
+sparse_ids sparse_pattern(const Xpr&) { return std::nullopt; }
+template <typename S>
+sparse_ids sparse_pattern(const basic_ndarray<S>& arr);
+template <typename Fn, typename Sen, typename... Xprs>
+sparse_ids sparse_pattern(const wise<Fn, Sen, Xprs...>& xpr);
+
+template <typename S>
+sparse_ids sparse_pattern(const basic_ndarray<S>& arr) {
+  if constexpr (is_sparse_leaf< basic_ndarray<S> >::value) {
+    std::vector<size_t> ids;
+    ids.reserve(arr->nnz());
+    arr->for_each([&](auto id, auto) { ids.push_back(id); });
+    if (!std::is_sorted(ids.begin(), ids.end())) std::sort(ids.begin(), ids.end());
+    return ids;
+  } else
+    return std::nullopt;
+}
+
+template
+< typename Fn,
+  typename Sen,
+  typename... Xprs >
+sparse_ids sparse_pattern(const wise<Fn, Sen, Xprs...>& xpr) {
+  constexpr auto rule = sparse_rule_of<Fn>::value;
+  if (rule == sparse_rule::dense || xpr.broadcasting()) return std::nullopt;
+
+  auto patterns = std::apply([](auto&&... x) { return std::array<sparse_ids, 1 + sizeof...(Xprs)>{sparse_pattern(x)...}; }, xpr.operands());
+  if (rule == sparse_rule::first) return patterns[0];
+
+  // sums need every pattern, products only the known ones
+  sparse_ids res;
+  for (auto& p : patterns) {
+    if (!p) {
+      if (rule == sparse_rule::merge) return std::nullopt;
+      continue;
+    }
+    if (!res) res = std::move(p);
+    else {
+      std::vector<size_t> ids;
+      if (rule == sparse_rule::merge) std::set_union(res->begin(), res->end(), p->begin(), p->end(), std::back_inserter(ids));
+      else
+        std::set_intersection(res->begin(), res->end(), p->begin(), p->end(), std::back_inserter(ids));
+      res = std::move(ids);
+    }
+  } return res;
+}
+
+// non-zero elements of an expression in linear order, only evaluated over its pattern when there is one
+template
+< typename T,
+  typename Xpr >
+auto sparse_entries(const Xpr& xpr) {
+  std::vector<size_t> ids;
+  std::vector<T> values;
+  auto keep = [&](size_t id) {
+    auto v = T(xpr.eval(id));
+    if (v != T(0)) {
+      ids.push_back(id);
+      values.push_back(v);
+    }
+  };
+
+  if (auto pattern = sparse_pattern(xpr)) for (auto id : *pattern) keep(id);
+  else
+    for (size_t id = 0; id < xpr.size(); ++id) keep(id);
+  return std::pair{std::move(ids), std::move(values)};
+}
+
+// Coordinate storage
+// construction format, entries are inserted in any order and must be compressed (sorted, duplicates summed) before use
+template <typename T>
+class coo : public sparse_layout {
+public:
+  using value_type = T;
+
+  coo() = default;
+  template <typename Shape>
+  explicit coo(const Shape& dims) : sparse_layout{dims} {}
+
+  auto nnz() const { return ids_.size(); }
+  auto values() const { return values_.data(); }
+
+  value_type operator()(size_t n) const {
+    assert(sorted_ && "Sparse ndarray used before compression");
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), n);
+    return it != ids_.end() && *it == n ? values_[it - ids_.begin()] : T(0);
+  }
+
+  void reserve(size_t n) {
+    ids_.reserve(n);
+    values_.reserve(n);
+  }
+
+  void insert(std::initializer_list<size_t> index, T value) {
+    assert(index.size() == dims() && "Invalid ndarray subscript");
+    auto id = std::inner_product(index.begin(), index.end(), strides_.begin(), size_t(0));
+    sorted_ = sorted_ && (ids_.empty() || ids_.back() < id);
+    ids_.push_back(id);
+    values_.push_back(value);
+  }
+
+  void compress();
+
+  // fn(linear index, value) over the non-zeros, in linear order
+  template <typename Fn>
+  void for_each(Fn&& fn) const {
+    assert(sorted_ && "Sparse ndarray used before compression");
+    for (size_t k = 0; k < ids_.size(); ++k) fn(ids_[k], values_[k]);
+  }
+
+  void assign(std::vector<size_t> ids, std::vector<T> values) {
+    ids_ = std::move(ids);
+    values_ = std::move(values);
+    sorted_ = true;
+  }
+
+  template <typename Xpr>
+  void assign(const Xpr& xpr) {
+    auto [ids, values] = sparse_entries<T>(xpr);
+    assign(std::move(ids), std::move(values));
+  }
+
+private:
+  std::vector<size_t> ids_;
+  std::vector<T> values_;
+  bool sorted_ = true;
+};
+
+template <typename T>
+void coo<T>::compress() {
+  std::vector<size_t> perm(ids_.size());
+  std::iota(perm.begin(), perm.end(), 0);
+  if (!sorted_) std::stable_sort(perm.begin(), perm.end(), [this](auto a, auto b) { return ids_[a] < ids_[b]; });
+
+  std::vector<size_t> ids;
+  std::vector<T> values;
+  ids.reserve(ids_.size());
+  values.reserve(values_.size());
+  for (size_t k = 0; k < perm.size();) {
+    auto id = ids_[perm[k]];
+    auto v = T(0);
+    for (; k < perm.size() && ids_[perm[k]] == id; ++k) v += values_[perm[k]];
+    if (v != T(0)) {
+      ids.push_back(id);
+      values.push_back(v);
+    }
+  } assign(std::move(ids), std::move(values));
+}
+
+// Compressed storage
+// fibers tree over the dimensions taken in a level order, each level stores the coordinates of its non-empty
+// fibers and the range of their children in the next one, the last level holds the values
+// (empty rows are not stored, so csr and csc are their doubly compressed forms)
+template
+< typename T,
+  typename Levels >
+class compressed : public sparse_layout {
+public:
+  using value_type = T;
+
+  compressed() = default;
+  template <typename Shape>
+  explicit compressed(const Shape& dims)
+    : sparse_layout{dims}
+    , levels_{Levels::order(shape_.size())}
+    , idx_(shape_.size())
+    , ptr_(shape_.size() ? shape_.size() - 1 : 0, std::vector<size_t>{0}) {}
+
+  auto nnz() const { return values_.size(); }
+  auto values() const { return values_.data(); }
+  auto& levels() const { return levels_; }
+
+  value_type operator()(size_t n) const;
+
+  // fn(linear index, value) over the non-zeros, in level order
+  template <typename Fn>
+  void for_each(Fn&& fn) const { if (!levels_.empty()) walk(0, 0, idx_[0].size(), 0, fn); }
+
+  void assign(std::vector<size_t> ids, std::vector<T> values);
+
+  template <typename Xpr>
+  void assign(const Xpr& xpr) {
+    auto [ids, values] = sparse_entries<T>(xpr);
+    assign(std::move(ids), std::move(values));
+  }
+
+private:
+  template <typename Fn>
+  void walk(size_t l, size_t begin, size_t end, size_t base, Fn& fn) const {
+    auto stride = strides_[levels_[l]];
+    for (auto k = begin; k < end; ++k) {
+      auto id = base + idx_[l][k] * stride;
+      if (l + 1 == levels_.size()) fn(id, values_[k]);
+      else
+        walk(l + 1, ptr_[l][k], ptr_[l][k + 1], id, fn);
+    }
+  }
+
+  std::vector<size_t> levels_;
+  std::vector< std::vector<size_t> > idx_, ptr_;
+  std::vector<T> values_;
+};
+
+template
+< typename T,
+  typename Levels >
+auto compressed<T, Levels>::operator()(size_t n) const -> value_type {
+  size_t begin = 0, end = levels_.empty() ? 0 : idx_[0].size();
+  for (size_t l = 0; l < levels_.size(); ++l) {
+    auto c = coordinate(n, levels_[l]);
+    auto first = idx_[l].begin();
+    auto it = std::lower_bound(first + begin, first + end, c);
+    if (it == first + end || *it != c) break;
+
+    auto k = size_t(it - first);
+    if (l + 1 == levels_.size()) return values_[k];
+    begin = ptr_[l][k];
+    end   = ptr_[l][k + 1];
+  } return T(0);
+}
+
+template
+< typename T,
+  typename Levels >
+void compressed<T, Levels>::assign(std::vector<size_t> ids, std::vector<T> values) {
+  auto depth = levels_.size();
+
+  // entries sorted along the levels, the last one being the fastest
+  std::vector<size_t> keys(ids.size()), perm(ids.size());
+  for (size_t k = 0; k < ids.size(); ++k)
+    for (auto d : levels_) keys[k] = keys[k] * shape_[d] + coordinate(ids[k], d);
+  std::iota(perm.begin(), perm.end(), 0);
+  if (!std::is_sorted(keys.begin(), keys.end())) std::sort(perm.begin(), perm.end(), [&](auto a, auto b) { return keys[a] < keys[b]; });
+
+  for (auto& idx : idx_) idx.clear();
+  for (auto& ptr : ptr_) ptr.clear();
+  values_.clear();
+  values_.reserve(values.size());
+
+  // each entry opens new fibers from the first level where it leaves the path of the previous one
+  for (size_t k = 0; k < perm.size(); ++k) {
+    auto id = ids[perm[k]];
+    size_t l = 0;
+    if (k)
+      while (l + 1 < depth && coordinate(id, levels_[l]) == coordinate(ids[perm[k - 1]], levels_[l])) ++l;
+
+    for (; l < depth; ++l) {
+      idx_[l].push_back(coordinate(id, levels_[l]));
+      if (l + 1 < depth) ptr_[l].push_back(idx_[l + 1].size());
+    } values_.push_back(values[perm[k]]);
+  }
+
+  // pointers hold the start of each fiber, the last one is closed here
+  for (size_t l = 0; l + 1 < depth; ++l) ptr_[l].push_back(idx_[l + 1].size());
+}
+
+// Level orders
+// csr and csc compress the rows and the columns of matrices,
+// csf starts from the last (slowest) dimension so that its traversal follows the linear order
+struct csr_levels {
+  static auto order(size_t dims) {
+    if (dims != 2) throw std::runtime_error{"[Ndarray] CSR storage requires 2 dimensions"};
+    return std::vector<size_t>{0, 1};
+  }
+};
+
+struct csc_levels {
+  static auto order(size_t dims) {
+    if (dims != 2) throw std::runtime_error{"[Ndarray] CSC storage requires 2 dimensions"};
+    return std::vector<size_t>{1, 0};
+  }
+};
+
+struct csf_levels {
+  static auto order(size_t dims) {
+    std::vector<size_t> levels(dims);
+    std::iota(levels.rbegin(), levels.rend(), 0);
+    return levels;
+  }
+};
 
+template <typename T> using csr = compressed<T, csr_levels>;
+template <typename T> using csc = compressed<T, csc_levels>;
+template <typename T> using csf = compressed<T, csf_levels>;
 
 } // namespace nd
 } // namespace ig
@@ -9,13 +9,18 @@
 
 #include "imagine/math/basis.h"
 #include "imagine/math/theory/detail/relational.h"
+#include "imagine/math/theory/detail/half.h"
+#include "imagine/math/theory/detail/ndarray/shape.h"
+#include "imagine/math/theory/simd_accel/intrinsics.h"
+#include "imagine/core/settings/serialize.h"
+#include "imagine/core/net/job.h"
 
 namespace ig {
 
 template <typename D> 
 class ndarray_base;
-template <typename T, size_t... D> 
-class ndarray;
+template <typename S> 
+class basic_ndarray;
 
 template <typename Spn> 
 class view_ranges;
@@ -23,9 +28,32 @@ class view_ranges;
 template <typename Xpr, typename Shp, typename Rng> class view;
 template <typename Xpr, typename Shp, typename Str> class domain;
 template <typename Xpr, typename Shp, typename Str> class transpose;
+template <typename Xpr> class tiling;
+template <typename Lhs, typename Rhs> class concatenation;
 
 template <typename Fn, typename Sen, typename... Xprs> class wise;
 
+template <typename Arr> class strided_iterator;
+template <typename Op, typename Xpr> class reduction;
+
+namespace nd {
+
+template <typename Alloc> class dense;
+template <typename T, typename Order> class blocked;
+template <typename T> class mmap_alloc;
+template <typename T, size_t... D> class static_alloc;
+
+// set of axes, from a single axis or a list
+struct axes {
+  axes(size_t axis) : v{axis} {}
+  axes(std::initializer_list<size_t> list) : v{list} {}
+  axes(std::vector<size_t> list) : v{std::move(list)} {}
+
+  std::vector<size_t> v;
+};
+
+} // namespace nd
+
 // Meta
 template <typename Xpr> struct ndarray_traits;
 template <typename Xpr> struct ndarray_traits<const Xpr> : ndarray_traits<Xpr> {};
@@ -33,9 +61,171 @@ template <typename Xpr> struct ndarray_traits<const Xpr> : ndarray_traits<Xpr> {
 template <typename Xpr>
 struct is_ndarray : std::is_base_of< ndarray_base< std::decay_t<Xpr> >, std::decay_t<Xpr> >{};
 
+template <typename Xpr> struct is_dense_leaf : std::false_type {};
+template <typename A>   struct is_dense_leaf< basic_ndarray< nd::dense<A> > > : std::true_type {};
+
+template <typename Xpr> struct is_blocked_leaf : std::false_type {};
+template <typename T, typename O> struct is_blocked_leaf< basic_ndarray< nd::blocked<T, O> > > : std::true_type {};
+
+template <typename Xpr> struct is_sparse_leaf : std::false_type {};
+template <typename S>   struct is_sparse_leaf< basic_ndarray<S> > : std::bool_constant< !is_dense_leaf< basic_ndarray<S> >::value && !is_blocked_leaf< basic_ndarray<S> >::value > {};
+
+template <typename Xpr> struct is_wise : std::false_type {};
+template <typename F, typename S, typename... X> struct is_wise< wise<F, S, X...> > : std::true_type {};
+template <typename Xpr> struct is_transpose : std::false_type {};
+template <typename X, typename Sh, typename St> struct is_transpose< transpose<X, Sh, St> > : std::true_type {};
+
+// nodes reading their operands out of place, see tiling and concatenation
+template <typename Xpr, typename = void> struct has_operands : std::false_type {};
+template <typename Xpr> struct has_operands< Xpr, std::void_t<decltype(std::declval<const Xpr&>().operands())> > : std::true_type {};
+
+template <typename Xpr> struct is_mapped_leaf : std::false_type {};
+template <typename T>   struct is_mapped_leaf< basic_ndarray< nd::dense< nd::mmap_alloc<T> > > > : std::true_type {};
+
+// nd::extents of arrays of static shape and of element-wise expressions over a single static shape, void otherwise
+template <typename Xpr> struct static_shape { using type = void; };
+template <typename T, size_t... D> struct static_shape< basic_ndarray< nd::dense< nd::static_alloc<T, D...> > > > { using type = nd::extents<D...>; };
+
+template <typename Xpr> using static_shape_t = typename static_shape< std::decay_t<Xpr> >::type;
+
 // Aliases
 template <typename Array> using ndarray_t = typename ndarray_traits< std::decay_t<Array> >::value_type;
 
+// Packets
+// simd type used for element-wise evaluation, width 1 means scalar only
+template <typename T>
+struct nd_packet {
+  using type = T;
+  static constexpr size_t width = 1;
+};
+
+#if defined(IG_X86) && defined(IG_AVX)
+template <>
+struct nd_packet<float> {
+  using type = float8;
+  static constexpr size_t width = 8;
+
+  static auto load(const float* src) { return type{_mm256_loadu_ps(src)}; }
+  static void store(float* dst, const type& v) { _mm256_storeu_ps(dst, v); }
+};
+#elif defined(IG_X86) && defined(IG_SSE)
+template <>
+struct nd_packet<float> {
+  using type = float4;
+  static constexpr size_t width = 4;
+
+  static auto load(const float* src) { return type{_mm_loadu_ps(src)}; }
+  static void store(float* dst, const type& v) { _mm_storeu_ps(dst, v); }
+};
+#endif
+
+// half precision elements are widened to float packets when loaded and narrowed back when stored
+#if defined(IG_X86) && defined(IG_SSE)
+template <typename H>
+struct nd_half_packet {
+  using type = typename nd_packet<float>::type;
+  static constexpr size_t width = nd_packet<float>::width;
+
+  static auto load(const H* src) {
+    alignas(IG_VECTOR_SIMD) float lanes[width];
+    convert_n(src, width, lanes);
+    return nd_packet<float>::load(lanes);
+  }
+  static void store(H* dst, const type& v) {
+    alignas(IG_VECTOR_SIMD) float lanes[width];
+    nd_packet<float>::store(lanes, v);
+    convert_n(lanes, width, dst);
+  }
+};
+
+template <> struct nd_packet<float16>  : nd_half_packet<float16>  {};
+template <> struct nd_packet<bfloat16> : nd_half_packet<bfloat16> {};
+#endif
+
+template <typename T> using packet_t = typename nd_packet<T>::type;
+
+// elements of type U evaluated over packets stored into elements of type T, e.g. float expressions into float16 arrays
+template 
+< typename T, 
+  typename U >
+constexpr bool same_packet = nd_packet<T>::width > 1 && std::is_same_v< packet_t<T>, packet_t<U> >;
+
+// packet built lane by lane from fn(lane)
+template 
+< typename T, 
+  typename Fn >
+auto gather_packet(Fn&& fn) {
+  using lane = widened_t<T>;
+  using packet = nd_packet<lane>;
+
+  alignas(IG_VECTOR_SIMD ? IG_VECTOR_SIMD : alignof(lane)) lane lanes[packet::width];
+  for (size_t i = 0; i < packet::width; ++i) lanes[i] = fn(i);
+  return packet::load(lanes);
+}
+
+// Steppers
+// cursor on a row (first dimension) of an expression, used to evaluate broadcast expressions row by row
+// move(d, n) shifts the row by n along dimension d > 0, eval(j) and eval_packet(j) read its element j
+template <typename T>
+class dense_stepper {
+public:
+  explicit dense_stepper(const T* data, const size_t* strides)
+    : row_{data}
+    , strides_{strides} {}
+
+  void move(size_t d, ptrdiff_t n) { row_ += ptrdiff_t(strides_[d]) * n; }
+
+  auto eval(size_t j) const { return row_[j]; }
+  auto eval_packet(size_t j) const { return nd_packet<T>::load(row_ + j); }
+
+private:
+  const T* row_;
+  const size_t* strides_;
+};
+
+template 
+< typename Src, 
+  typename Strides >
+class strided_stepper {
+public:
+  explicit strided_stepper(const Src& src, size_t offset, const Strides& strides)
+    : src_{src}
+    , offset_{offset}
+    , strides_{strides} {}
+
+  void move(size_t d, ptrdiff_t n) { offset_ += strides_[d] * size_t(n); }
+
+  auto eval(size_t j) const { return src_.eval(offset_ + j * strides_[0]); }
+  auto eval_packet(size_t j) const { return gather_packet< ndarray_t<Src> >([&](auto i) { return eval(j + i); }); }
+
+private:
+  const Src& src_;
+  size_t offset_;
+  const Strides& strides_;
+};
+
+template <typename Xpr>
+class linear_stepper {
+public:
+  explicit linear_stepper(const Xpr& xpr)
+    : xpr_{xpr}
+    , offset_{0}
+    , strides_(xpr.dims(), 1) {
+
+    for (size_t d = 1; d < strides_.size(); ++d) strides_[d] = strides_[d - 1] * xpr.shape()[d - 1];
+  }
+
+  void move(size_t d, ptrdiff_t n) { offset_ += strides_[d] * size_t(n); }
+
+  auto eval(size_t j) const { return xpr_.eval(offset_ + j); }
+  auto eval_packet(size_t j) const { return xpr_.eval_packet(offset_ + j); }
+
+private:
+  const Xpr& xpr_;
+  size_t offset_;
+  nd::inline_shape<> strides_;
+};
+
 template <typename D>
 class ndarray_base : public xpr<D> {
 public:
@@ -46,9 +236,9 @@ public:
   //using base::begin;
   //using base::end;
 
-  auto begin() const { return base::ndbegin(); }
+  auto begin() const { return derived().ndbegin(); }
   auto begin()       { return base::ndbegin(); }
-  auto end() const   { return base::ndend(); }
+  auto end() const   { return derived().ndend(); }
   auto end()         { return base::ndend(); }
 
   auto size() const { return derived().size(); }
@@ -82,26 +272,56 @@ public:
   auto operator[](size_t dimension) const
   { return shape()[dimension]; }
 
-  auto& operator+=(value_type value)
-  { return derived() = std::move(*this) + value; }
-  auto& operator-=(value_type value)
-  { return derived() = std::move(*this) - value; }
-  auto& operator*=(value_type value)
-  { return derived() = std::move(*this) * value; }
-  auto& operator/=(value_type value)
-  { return derived() = std::move(*this) / value; }
+  auto& operator+=(widened_t<value_type> value) { return update(value, std::plus<>{}); }
+  auto& operator-=(widened_t<value_type> value) { return update(value, std::minus<>{}); }
+  auto& operator*=(widened_t<value_type> value) { return update(value, std::multiplies<>{}); }
+  auto& operator/=(widened_t<value_type> value) { return update(value, std::divides<>{}); }
 
   template <typename Arr>
-  auto& operator+=(const ndarray_base<Arr>& arr) { return derived() = std::move(*this) + arr; }
+  auto& operator+=(const ndarray_base<Arr>& arr) { return update(arr, std::plus<>{}); }
   template <typename Arr>
-  auto& operator-=(const ndarray_base<Arr>& arr) { return derived() = std::move(*this) - arr; }
+  auto& operator-=(const ndarray_base<Arr>& arr) { return update(arr, std::minus<>{}); }
   template <typename Arr>
-  auto& operator*=(const ndarray_base<Arr>& arr) { return derived() = std::move(*this) * arr; }
+  auto& operator*=(const ndarray_base<Arr>& arr) { return update(arr, std::multiplies<>{}); }
   template <typename Arr>
-  auto& operator/=(const ndarray_base<Arr>& arr) { return derived() = std::move(*this) / arr; }
-
-  auto sum() const  -> value_type;
-  auto prod() const -> value_type;
+  auto& operator/=(const ndarray_base<Arr>& arr) { return update(arr, std::divides<>{}); }
+
+  // expressions evaluating natively over packets, others gather their packet element by element
+  static constexpr bool packed = false;
+  auto eval_packet(size_t id) const;
+
+  // expressions walking a strided layout over source(), see for_each_row
+  static constexpr bool strided = false;
+
+  // expressions repeating some of their operands along a dimension, evaluated through steppers
+  bool broadcasting() const { return false; }
+  auto stepper() const { return linear_stepper<D>{derived()}; }
+
+  // whole array reductions, in the widened type (see widened_t) as the reductions along axes
+  auto sum() const  -> widened_t<value_type>;
+  auto prod() const -> widened_t<value_type>;
+
+  // reductions along axes, lazy expressions over the remaining dimensions
+  auto sum(const nd::axes& axes) const;
+  auto prod(const nd::axes& axes) const;
+  auto min(const nd::axes& axes) const;
+  auto max(const nd::axes& axes) const;
+  auto mean(const nd::axes& axes) const;
+  auto argmax(const nd::axes& axes) const;
+
+  // expressions writing themselves into a dense destination, see eval_into
+  static constexpr bool direct = false;
+
+  auto fingerprint() const -> hash128;
+
+protected:
+  // in-place compound assignment, derived() = op(derived(), rhs) in a single pass, see ndarray.h
+  template <typename Op> 
+  auto& update(widened_t<value_type> value, Op op);
+  template 
+  < typename Arr, 
+    typename Op >
+  auto& update(const ndarray_base<Arr>& arr, Op op);
 };
 
 template <typename D>
@@ -114,31 +334,301 @@ bool ndarray_base<D>::is_balanced() const {
 }
 
 template <typename D>
-auto ndarray_base<D>::sum() const -> value_type
-{ return std::accumulate(begin(), end(), value_type(0)); }
+auto ndarray_base<D>::eval_packet(size_t id) const 
+{ return gather_packet<value_type>([&](auto i) { return derived().eval(id + i); }); }
+
+namespace nd {
+
+// Evaluation policy
+// assignments of at least threshold elements are split over the job::get() workers (threads = 0 uses all of them),
+// a chunk covers about chunk bytes of the destination and starts on a packet boundary
+struct eval_policy {
+  size_t threads   = 0;
+  size_t threshold = size_t(1) << 18;
+  size_t chunk     = size_t(1) << 16;
+};
 
-template <typename D>
-auto ndarray_base<D>::prod() const -> value_type
-{ return std::accumulate(begin(), end(), value_type(1), std::multiplies<>{}); }
+constexpr eval_policy sequential{1};
+
+// global policy used by assignments, meant to be set up once before evaluating in parallel
+inline auto& policy() { 
+  static eval_policy global{};
+  return global;
+}
+
+// window by window evaluation into array files, see mapped.h
+template <typename Gen, typename Xpr> void stream(Gen& ev, const Xpr& xpr, const eval_policy& policy);
+
+} // namespace nd
+
+template 
+< typename T, 
+  typename Arr >
+void eval_range(T* dst, const Arr& xpr, size_t begin, size_t end) {
+  using packet = nd_packet<T>;
+  auto i = begin;
+  if constexpr (Arr::packed && same_packet<T, ndarray_t<Arr>>) {
+    for (; i + packet::width <= end; i += packet::width) packet::store(dst + i, xpr.eval_packet(i));
+  } 
+  for (; i < end; ++i) dst[i] = xpr.eval(i);
+}
+
+// rows [begin, end) of a strided expression written one after the other from out
+template 
+< typename T, 
+  typename Arr >
+void eval_rows_at(T* dst, const Arr& xpr, size_t begin, size_t end) {
+  auto& src = xpr.source();
+  for_each_row(xpr, [&](auto offset, auto stride, auto length) {
+    if constexpr (is_dense_leaf< std::decay_t<decltype(src)> >::value) {
+      auto row = src.data() + offset;
+      if (stride == 1) convert_n(row, length, dst);
+      else 
+        for (size_t j = 0; j < length; ++j) dst[j] = row[j * stride];
+    } else {
+      if (stride == 1) for (size_t j = 0; j < length; ++j) dst[j] = src.eval(offset + j);
+      else 
+        for (size_t j = 0; j < length; ++j) dst[j] = src.eval(offset + j * stride);
+    } dst += length;
+  }, begin, end);
+}
+
+template 
+< typename T, 
+  typename Arr >
+void eval_rows(T* dst, const Arr& xpr, size_t begin, size_t end) { eval_rows_at(dst + begin * xpr.shape()[0], xpr, begin, end); }
+
+// rows [begin, end) of a broadcasting expression written one after the other from out, through its stepper
+template 
+< typename T, 
+  typename Arr >
+void eval_steps_at(T* dst, const Arr& xpr, size_t begin, size_t end) {
+  using packet = nd_packet<T>;
+  auto& shape = xpr.shape();
+  auto length = shape[0];
+  auto stepper = xpr.stepper();
+
+  nd::inline_shape<> index(xpr.dims(), 0);
+  for (size_t d = 1, row = begin; d < index.size(); ++d) {
+    index[d] = row % shape[d];
+    row /= shape[d];
+    stepper.move(d, index[d]);
+  }
+
+  for (auto row = begin; row < end; ++row, dst += length) {
+    size_t j = 0;
+    if constexpr (Arr::packed && same_packet<T, ndarray_t<Arr>>) {
+      for (; j + packet::width <= length; j += packet::width) packet::store(dst + j, stepper.eval_packet(j));
+    }
+    for (; j < length; ++j) dst[j] = stepper.eval(j);
+
+    for (size_t d = 1; d < index.size(); ++d) {
+      stepper.move(d, 1);
+      if (++index[d] < shape[d]) break;
+      stepper.move(d, -ptrdiff_t(shape[d]));
+      index[d] = 0;
+    }
+  }
+}
+
+template 
+< typename T, 
+  typename Arr >
+void eval_steps(T* dst, const Arr& xpr, size_t begin, size_t end) { eval_steps_at(dst + begin * xpr.shape()[0], xpr, begin, end); }
+
+// out[j] = xpr.eval(from + j) for j < n, strided and broadcasting expressions are read by rows when the span covers
+// whole rows, others over packets when they have them
+template
+< typename T,
+  typename Xpr >
+void eval_span(T* out, const Xpr& xpr, size_t from, size_t n) {
+  using packet = nd_packet<T>;
+  size_t j = 0;
+  if constexpr (is_dense_leaf<Xpr>::value) {
+    convert_n(xpr.data() + from, n, out);
+    return;
+  } else if constexpr (Xpr::strided) {
+    auto length = xpr.shape()[0];
+    if (length && from % length == 0 && n % length == 0) {
+      eval_rows_at(out, xpr, from / length, (from + n) / length);
+      return;
+    }
+  } else {
+    if (xpr.broadcasting()) {
+      auto length = xpr.shape()[0];
+      if (length && from % length == 0 && n % length == 0) {
+        eval_steps_at(out, xpr, from / length, (from + n) / length);
+        return;
+      }
+    } else if constexpr (Xpr::packed && same_packet<T, ndarray_t<Xpr>>) {
+      for (; j + packet::width <= n; j += packet::width) packet::store(out + j, xpr.eval_packet(from + j));
+    }
+  }
+  for (; j < n; ++j) out[j] = xpr.eval(from + j);
+}
+
+// Static evaluation
+// expressions of compile-time extents are written as an unrolled sequence of packets followed by the remaining elements,
+// without threads, broadcasting or row bookkeeping
+template
+< typename T,
+  typename Arr,
+  size_t... P >
+void eval_packets(T* dst, const Arr& xpr, std::index_sequence<P...>) {
+  using packet = nd_packet<T>;
+  (packet::store(dst + P * packet::width, xpr.eval_packet(P * packet::width)), ...);
+}
+
+template
+< size_t Begin,
+  typename T,
+  typename Arr,
+  size_t... E >
+void eval_elements(T* dst, const Arr& xpr, std::index_sequence<E...>) { ((dst[Begin + E] = xpr.eval(Begin + E)), ...); }
+
+template
+< size_t N,
+  typename T,
+  typename Arr >
+void eval_fixed(T* dst, const Arr& xpr) {
+  if constexpr (Arr::packed && same_packet<T, ndarray_t<Arr>>) {
+    constexpr auto width = nd_packet<T>::width;
+    eval_packets(dst, xpr, std::make_index_sequence<N / width>{});
+    eval_elements<N - N % width>(dst, xpr, std::make_index_sequence<N % width>{});
+  } else 
+    eval_elements<0>(dst, xpr, std::make_index_sequence<N>{});
+}
 
 template 
 < typename Gen, 
   typename Arr >
-decltype(auto) eval_helper(ndarray_base<Gen>& ev, const ndarray_base<Arr>& arr) {
+decltype(auto) eval_helper(ndarray_base<Gen>& ev, const ndarray_base<Arr>& arr, const nd::eval_policy& policy = nd::policy()) {
   assert(
     ev.dims() == 
     arr.dims() &&
     ev.size() == 
     arr.size() && "Incoherent ndarray expression evaluation");
 
-  std::transform(
-    arr.begin(), 
-    arr.end(), 
-    ev.begin(), 
-    [](auto&& element) { return element; });
+  if constexpr (is_dense_leaf<Gen>::value) {
+    using value_type = ndarray_t<Gen>;
+    auto& xpr = arr.derived();
+    auto dst = ev.derived().data();
+    auto n = arr.size();
+    auto threads = n < policy.threshold ? 1 : policy.threads;
+
+    // strided and broadcast expressions are split by rows, others by packet-aligned index ranges
+    if constexpr (!std::is_void_v<static_shape_t<Arr>> && std::is_same_v<static_shape_t<Arr>, static_shape_t<Gen>>) 
+      eval_fixed<static_shape_t<Arr>::size>(dst, xpr);
+    else if constexpr (Arr::direct) xpr.eval_into(dst, policy);
+    else if constexpr (Arr::strided) {
+      auto length = n ? xpr.shape()[0] : 1;
+      auto rows = n / length;
+      if (threads == 1) eval_rows(dst, xpr, 0, rows);
+      else 
+        job::get().parallel_for(
+          rows, 
+          policy.chunk / (sizeof(value_type) * length),
+          [&](auto begin, auto end) { eval_rows(dst, xpr, begin, end); }, 
+          threads);
+    } else {
+      constexpr auto width = nd_packet<value_type>::width;
+      if (xpr.broadcasting()) {
+        auto length = n ? xpr.shape()[0] : 1;
+        auto rows = n / length;
+        if (threads == 1) eval_steps(dst, xpr, 0, rows);
+        else 
+          job::get().parallel_for(
+            rows, 
+            policy.chunk / (sizeof(value_type) * length),
+            [&](auto begin, auto end) { eval_steps(dst, xpr, begin, end); }, 
+            threads);
+      } else if constexpr (is_mapped_leaf<Gen>::value) nd::stream(ev.derived(), xpr, policy);
+      else if (threads == 1) eval_range(dst, xpr, 0, n);
+      else 
+        job::get().parallel_for(
+          n, 
+          align(std::max(policy.chunk / sizeof(value_type), width), width),
+          [&](auto begin, auto end) { eval_range(dst, xpr, begin, end); }, 
+          threads);
+    }
+  } else if constexpr (is_blocked_leaf<Gen>::value) {
+    ev.derived()->assign(arr.derived(), policy);
+  } else if constexpr (is_sparse_leaf<Gen>::value) {
+    ev.derived()->assign(arr.derived());
+  } else {
+    std::transform(
+      arr.begin(), 
+      arr.end(), 
+      ev.begin(), 
+      [](auto&& element) { return element; });
+  }
   return ev;
 }
 
+namespace nd {
+
+// Aliasing
+// memory read and written through an expression, the buffer of dense and blocked leaves and of strided nodes over them
+struct footprint {
+  const void* begin = nullptr;
+  const void* end   = nullptr;
+
+  bool overlaps(const footprint& o) const { return begin && o.begin && begin < o.end && o.begin < end; }
+};
+
+template <typename Xpr>
+auto footprint_of(const Xpr& xpr) -> footprint {
+  if constexpr (is_dense_leaf<Xpr>::value) return {xpr.data(), xpr.data() + xpr.size()};
+  else if constexpr (is_blocked_leaf<Xpr>::value) return {xpr.data(), xpr.data() + xpr->capacity()};
+  else if constexpr (Xpr::strided) return footprint_of(xpr.source());
+  else 
+    return {};
+}
+
+// the same elements in the same order, e.g. the destination repeated in its own update
+template <typename Xpr, typename Dst>
+bool same_layout(const Xpr& xpr, const Dst& dst) {
+  if constexpr (!std::is_same_v<Xpr, Dst>) return false;
+  else if constexpr (is_dense_leaf<Xpr>::value || is_blocked_leaf<Xpr>::value) return xpr.data() == dst.data() && xpr.shape() == dst.shape();
+  else if constexpr (Xpr::strided) {
+    auto fx = footprint_of(xpr), fd = footprint_of(dst);
+    return
+      fx.begin == fd.begin &&
+      xpr.offset() == dst.offset() &&
+      std::equal(xpr.shape().begin(), xpr.shape().end(), dst.shape().begin(), dst.shape().end()) &&
+      std::equal(xpr.strides().begin(), xpr.strides().end(), dst.strides().begin(), dst.strides().end());
+  } else 
+    return &xpr == &dst;
+}
+
+// whether evaluating xpr element by element into dst may read an element of dst already overwritten, i.e. xpr reads 
+// the memory of dst elsewhere than at the index being written (transposes, views, broadcasts or reductions over it),
+// such right-hand sides are materialized before the assignment
+template 
+< typename Xpr, 
+  typename Dst >
+bool aliased(const Xpr& xpr, const Dst& dst, const footprint& written, bool elementwise = true) {
+  if (!written.begin) return false;
+  if (same_layout(xpr, dst)) return !elementwise;
+
+  if constexpr (is_dense_leaf<Xpr>::value || is_blocked_leaf<Xpr>::value) return footprint_of(xpr).overlaps(written);
+  else if constexpr (is_sparse_leaf<Xpr>::value) return false;
+  else if constexpr (Xpr::strided) return aliased(xpr.source(), dst, written, false);
+  else if constexpr (is_wise<Xpr>::value)
+    return std::apply([&](auto&&... x) { return (aliased(x, dst, written, elementwise) || ...); }, xpr.operands());
+  else if constexpr (has_operands<Xpr>::value)
+    return std::apply([&](auto&&... x) { return (aliased(x, dst, written, false) || ...); }, xpr.operands());
+  else 
+    return true;
+}
+
+template 
+< typename Xpr, 
+  typename Dst >
+bool aliased(const Xpr& xpr, const Dst& dst) { return aliased(xpr, dst, footprint_of(dst)); }
+
+} // namespace nd
+
 template <typename Arr>
 inline std::ostream& operator<<(std::ostream& stream, const ndarray_base<Arr>& arr) {
   size_t width = 0;
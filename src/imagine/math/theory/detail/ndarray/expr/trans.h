@@ -8,6 +8,7 @@
 #define IG_MATH_NDARRAYTRANS_H
 
 #include "imagine/math/theory/detail/ndarray/view.h"
+#include "imagine/math/theory/detail/transposition.h"
 
 namespace ig {
 
@@ -49,6 +50,15 @@ public:
   template <typename... Id> 
   decltype(auto) operator()(Id... ids)       { return std::apply([&](auto&&... x) { return xpr_(x...); }, reverse(std::forward_as_tuple(ids...))); }
 
+  static constexpr bool strided = true;
+  auto& source() const { return xpr_; }
+  auto offset() const { return size_t(0); }
+
+  auto stepper() const { return strided_stepper{xpr_, size_t(0), strides_}; }
+
+  auto ndbegin() const { return strided_iterator<transpose>{*this, 0}; }
+  auto ndend() const   { return strided_iterator<transpose>{*this, size()}; }
+
   decltype(auto) eval(size_t id) const {
     return eval_strided(
       [this](auto i) { return i < dims() - 1; },
@@ -58,6 +68,11 @@ public:
        id);
   }
 
+  // transposes of dense arrays are written tile by tile, see transpose_into
+  static constexpr bool direct = is_dense_leaf< std::decay_t<x_> >::value;
+  template <typename T>
+  void eval_into(T* dst, const nd::eval_policy& policy) const;
+
 private:
   x_ xpr_;
   sh_ shape_;
@@ -72,6 +87,60 @@ template
   explicit transpose(x_ xpr, const sh_& shape, const st_& stride) 
         -> transpose< std::conditional_t<std::is_reference_v<x_>, x_, x_&>, sh_, st_ >;
 
+// the first and last source dimensions form transposed planes, indexed by the middle ones,
+// planes are split by tiles of rows over the job::get() workers
+template 
+< typename x_,
+  typename sh_,
+  typename st_ >
+template <typename T>
+void transpose<x_, sh_, st_>::eval_into(T* dst, const nd::eval_policy& policy) const {
+  auto n = size();
+  if (!n) return;
+  if constexpr (!std::is_same_v< T, std::remove_cv_t< ndarray_t<x_> > >) eval_rows(dst, *this, 0, n / shape_[0]);
+  else {
+    auto src = xpr_.data();
+    auto& shape   = xpr_.shape();
+    auto& strides = xpr_.strides();
+    auto k = dims() - 1;
+    if (!k) {
+      std::copy_n(src, n, dst);
+      return;
+    }
+
+    auto rows = shape[k], cols = shape[0];
+    auto lds = strides[k], ldd = n / cols;
+    nd::inline_shape<> dstrides(k + 1, 1);
+    for (auto m = k - 1; m > 0; --m) dstrides[m] = dstrides[m + 1] * shape[m + 1];
+
+    auto tile  = transpose_tile<T>;
+    auto tiles = (rows + tile - 1) / tile;
+    auto walk = [&](size_t begin, size_t end) {
+      for (auto u = begin; u < end; ++u) {
+        size_t so = 0, dof = 0;
+        for (size_t m = 1, p = u / tiles; m < k; ++m) {
+          auto im = p % shape[m];
+          p  /= shape[m];
+          so += im * strides[m];
+          dof += im * dstrides[m];
+        }
+        auto r = (u % tiles) * tile;
+        transpose_into(dst + dof + r, ldd, src + so + r * lds, lds, std::min(tile, rows - r), cols);
+      }
+    };
+
+    auto units = tiles * (n / (rows * cols));
+    auto threads = n < policy.threshold ? 1 : policy.threads;
+    if (threads == 1) walk(0, units);
+    else 
+      job::get().parallel_for(
+        units, 
+        std::max<size_t>(1, policy.chunk / (sizeof(T) * tile * cols)),
+        walk,
+        threads);
+  }
+}
+
 } // namespace ig
 
 #endif // IG_MATH_NDARRAYTRANS_H
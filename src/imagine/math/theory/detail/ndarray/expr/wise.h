@@ -17,49 +17,261 @@ struct ndarray_traits
   wise<Fn, Sen, Xprs...>
 >
 {
-  using value_type = std::common_type_t<ndarray_t<Sen>, ndarray_t<Xprs>...>;
+  using value_type = std::common_type_t< widened_t<ndarray_t<Sen>>, widened_t<ndarray_t<Xprs>>... >;
 };
 
+template <typename Fn, typename Sen, typename... Xprs>
+struct static_shape
+<
+  wise<Fn, Sen, Xprs...>
+>
+{
+  using type = std::conditional_t< (std::is_same_v< static_shape_t<Sen>, static_shape_t<Xprs> > && ...), static_shape_t<Sen>, void >;
+};
+
+// Packet operators
+// element-wise functors with a packet counterpart, resolved here so that the simd operators are found
+template <typename P> auto packet_apply(const std::negate<>&, const P& x) { return -x; }
+
+template <typename P> auto packet_apply(const std::plus<>&,       const P& lhs, const P& rhs) { return lhs + rhs; }
+template <typename P> auto packet_apply(const std::minus<>&,      const P& lhs, const P& rhs) { return lhs - rhs; }
+template <typename P> auto packet_apply(const std::multiplies<>&, const P& lhs, const P& rhs) { return lhs * rhs; }
+template <typename P> auto packet_apply(const std::divides<>&,    const P& lhs, const P& rhs) { return lhs / rhs; }
+
+// scalar operand bound on the left (lhs op x) or the right (x op rhs)
+template 
+< typename Op, 
+  typename S, 
+  bool Left >
+struct scalar_op {
+  template <typename X>
+  constexpr auto operator()(X&& x) const { 
+    if constexpr (Left) return op(s, std::forward<X>(x)); 
+    else 
+      return op(std::forward<X>(x), s); 
+  }
+
+  Op op;
+  S s;
+};
+
+template <typename P, typename Op, typename S, bool Left> 
+auto packet_apply(const scalar_op<Op, S, Left>& f, const P& x) -> decltype(packet_apply(f.op, x, x)) {
+  auto s = P(static_cast<std::decay_t<decltype(std::declval<P>()[0])>>(f.s));
+  if constexpr (Left) return packet_apply(f.op, s, x);
+  else 
+    return packet_apply(f.op, x, s);
+}
+
+template <typename Fn, typename P, typename Ps, typename = void> 
+struct has_packet_op : std::false_type {};
+template <typename Fn, typename P, typename... Ps> 
+struct has_packet_op< Fn, P, std::tuple<Ps...>, std::void_t<decltype(packet_apply(std::declval<const Fn&>(), std::declval<const Ps&>()...))> > : std::true_type {};
+
+// Broadcast stepper
+// operands repeated along a dimension (zero stride) ignore moves along it, and read a single element 
+// of their row when repeated along the first dimension
+template 
+< typename Fn, 
+  typename T,
+  typename... Steppers >
+class wise_stepper {
+public:
+  static constexpr auto N = sizeof...(Steppers);
+
+  explicit wise_stepper(const Fn& op, const std::array<nd::inline_shape<>, N>* strides, Steppers... steppers)
+    : op_{op}
+    , strides_{strides}
+    , steppers_{steppers...} {}
+
+  void move(size_t d, ptrdiff_t n) 
+  { move(d, n, std::index_sequence_for<Steppers...>{}); }
+
+  auto eval(size_t j) const 
+  { return eval(j, std::index_sequence_for<Steppers...>{}); }
+  auto eval_packet(size_t j) const 
+  { return eval_packet(j, std::index_sequence_for<Steppers...>{}); }
+
+private:
+  bool repeated(size_t k, size_t d) const { return strides_ && (*strides_)[k][d] == 0; }
+
+  template <size_t... K> 
+  void move(size_t d, ptrdiff_t n, std::index_sequence<K...>) 
+  { ((repeated(K, d) ? void() : std::get<K>(steppers_).move(d, n)), ...); }
+
+  template <size_t... K> 
+  auto eval(size_t j, std::index_sequence<K...>) const 
+  { return op_(std::get<K>(steppers_).eval(repeated(K, 0) ? 0 : j)...); }
+
+  template <size_t... K> 
+  auto eval_packet(size_t j, std::index_sequence<K...>) const 
+  { return packet_apply(op_, (repeated(K, 0) ? packet_t<T>(std::get<K>(steppers_).eval(0)) : std::get<K>(steppers_).eval_packet(j))...); }
+
+  const Fn& op_;
+  const std::array<nd::inline_shape<>, N>* strides_;
+  std::tuple<Steppers...> steppers_;
+};
+
+// Element-wise expression
+// operand shapes are aligned on their first (fastest) dimension, missing trailing dimensions and dimensions 
+// of extent 1 are repeated lazily over the result shape through zero strides
 template
 < typename f_,
   typename s_,
   typename... x_ >
 class wise : public ndarray_base< wise<f_, s_, x_...> > {
 public:
+  static constexpr auto N = 1 + sizeof...(x_);
+  using extents_type = static_shape_t<wise>;
+  static constexpr bool fixed = !std::is_void_v<extents_type>;
+
   explicit constexpr wise(const f_& op, s_ sen, x_... xprs)
     : op_{op}
     , sen_{sen}
     , xprs_{std::forward_as_tuple(xprs...)} {
 
+    // static shapes are neither laid out nor broadcast
+    if constexpr (!fixed) {
       std::apply(
         [this](auto&&... x) {
-          assert(
-            (std::equal(
-              sen_.shape().begin(), 
-              sen_.shape().end(), 
-              x.shape().begin()) && 
-            ...) && "Invalid ndarray wise operation");
+          layout_.shape.assign(std::max({x.dims()...}), 1);
+          ([this](auto& arr) {
+            for (size_t d = 0; d < arr.dims(); ++d) {
+              assert(
+                (arr.shape()[d] == layout_.shape[d] || 
+                 arr.shape()[d] == 1 || 
+                 layout_.shape[d] == 1) && "Invalid ndarray wise operation");
+              if (layout_.shape[d] == 1) layout_.shape[d] = arr.shape()[d];
+            }
+          }(x), ...);
+          layout_.broadcast = ((x.dims() != layout_.shape.size() || !std::equal(layout_.shape.begin(), layout_.shape.end(), x.shape().begin())) || ...);
         }, 
-        xprs_);
+        operands());
+
+      layout_.strides.resize(layout_.shape.size());
+      for (size_t d = 0; d < layout_.shape.size(); ++d) {
+        layout_.strides[d] = layout_.size;
+        layout_.size *= layout_.shape[d];
+      }
+
+      // operand strides over the result shape, zero along repeated dimensions
+      if (layout_.broadcast) {
+        std::apply(
+          [this](auto&&... x) {
+            size_t k = 0;
+            ([this, &k](auto& arr) {
+              auto& strides = layout_.bstrides[k++];
+              strides.assign(layout_.shape.size(), 0);
+              for (size_t d = 0, stride = 1; d < arr.dims(); stride *= arr.shape()[d++])
+                if (arr.shape()[d] != 1) strides[d] = stride;
+            }(x), ...);
+          },
+          operands());
+      }
     }
+  }
 
-  auto size() const { return sen_.size(); }
-  auto dims() const { return sen_.dims(); }
-  auto& shape() const   { return sen_.shape(); }
-  auto& strides() const { return sen_.strides(); }
+  auto size() const { 
+    if constexpr (fixed) return extents_type::size; 
+    else 
+      return layout_.size; 
+  }
+  auto dims() const { 
+    if constexpr (fixed) return extents_type::dims; 
+    else 
+      return layout_.shape.size(); 
+  }
+  auto shape() const -> decltype(auto) { 
+    if constexpr (fixed) return (extents_type::shape); 
+    else 
+      return (layout_.shape); 
+  }
+  auto strides() const -> decltype(auto) { 
+    if constexpr (fixed) return (extents_type::strides); 
+    else 
+      return (layout_.strides); 
+  }
 
   template <typename... Id> 
-  auto operator()(Id... ids) const 
-  { return std::apply([&](auto&&... x) { return op_(sen_(ids...), x(ids...)...); }, xprs_); }
+  auto operator()(Id... ids) const {
+    if (broadcast()) {
+      size_t is[] = {size_t(ids)...};
+      return eval(std::inner_product(std::begin(is), std::end(is), strides().begin(), size_t(0)));
+    } return std::apply([&](auto&&... x) { return op_(sen_(ids...), x(ids...)...); }, xprs_);
+  }
+
+  auto eval(size_t id) const {
+    if constexpr (!fixed) if (layout_.broadcast) return eval_broadcast(id);
+    return std::apply([&](auto&&... x) { return op_(sen_.eval(id), x.eval(id)...); }, xprs_);
+  }
 
-  auto eval(size_t id) const 
-  { return std::apply([&](auto&&... x) { return op_(sen_.eval(id), x.eval(id)...); }, xprs_); }
+  using value_type = ndarray_t<wise>;
+  static constexpr bool packed = 
+    nd_packet<value_type>::width > 1 &&
+    std::decay_t<s_>::packed && (std::decay_t<x_>::packed && ...) &&
+    same_packet<ndarray_t<s_>, value_type> && (same_packet<ndarray_t<x_>, value_type> && ...) &&
+    has_packet_op< f_, packet_t<value_type>, std::tuple< packet_t<ndarray_t<s_>>, packet_t<ndarray_t<x_>>... > >::value;
+
+  // linear packets, broadcast expressions are evaluated through their stepper instead
+  auto eval_packet(size_t id) const {
+    if constexpr (packed) return std::apply([&](auto&&... x) { return packet_apply(op_, sen_.eval_packet(id), x.eval_packet(id)...); }, xprs_);
+    else 
+      return ndarray_base<wise>::eval_packet(id);
+  }
+
+  bool broadcasting() const 
+  { return broadcast() || std::apply([](auto&&... x) { return (x.broadcasting() || ...); }, operands()); }
+
+  auto stepper() const {
+    return std::apply(
+      [this](auto&&... x) { return wise_stepper< f_, value_type, decltype(x.stepper())... >{op_, bstrides(), x.stepper()...}; }, 
+      operands());
+  }
+
+  auto operands() const { return std::tuple_cat(std::forward_as_tuple(sen_), xprs_); }
 
 private:
+  bool broadcast() const {
+    if constexpr (fixed) return false;
+    else 
+      return layout_.broadcast;
+  }
+
+  auto bstrides() const -> const std::array<nd::inline_shape<>, N>* {
+    if constexpr (fixed) return nullptr;
+    else 
+      return layout_.broadcast ? &layout_.bstrides : nullptr;
+  }
+
+  auto eval_broadcast(size_t id) const {
+    std::array<size_t, N> ids{};
+    for (size_t d = 0; d < layout_.shape.size(); ++d) {
+      auto i = id % layout_.shape[d];
+      id /= layout_.shape[d];
+      for (size_t k = 0; k < N; ++k) ids[k] += i * layout_.bstrides[k][d];
+    }
+    return eval_at(ids, std::make_index_sequence<N>{});
+  }
+
+  template <size_t... K>
+  auto eval_at(const std::array<size_t, N>& ids, std::index_sequence<K...>) const 
+  { return op_(std::get<K>(operands()).eval(ids[K])...); }
+
   f_ op_;
   s_ sen_;
   std::tuple<x_...> 
   xprs_;
+
+  // result shape and operand strides over it, static shapes have none
+  struct layout {
+    nd::inline_shape<> shape, strides;
+    std::array<nd::inline_shape<>, N> bstrides;
+    size_t size = 1;
+    bool broadcast = false;
+  };
+  struct static_layout {};
+
+  std::conditional_t<fixed, static_layout, layout> layout_;
 };
 
 // deduction
@@ -99,17 +311,17 @@ using swise =
      (std::is_same_v<ndarray_t<Xpr>, S> && std::is_trivially_copyable_v<S>)
   >;
 
-template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator+(const ndarray_base<Lhs>& lhs, S rhs) { return wise{[rhs](auto&& x) { return x + rhs; }, lhs.derived()}; }
-template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator+(S lhs, const ndarray_base<Rhs>& rhs) { return wise{[lhs](auto&& x) { return lhs + x; }, rhs.derived()}; }
+template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator+(const ndarray_base<Lhs>& lhs, S rhs) { return wise{scalar_op<std::plus<>, S, false>{{}, rhs}, lhs.derived()}; }
+template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator+(S lhs, const ndarray_base<Rhs>& rhs) { return wise{scalar_op<std::plus<>, S, true>{{}, lhs}, rhs.derived()}; }
 
-template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator-(const ndarray_base<Lhs>& lhs, S rhs) { return wise{[rhs](auto&& x) { return x - rhs; }, lhs.derived()}; }
-template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator-(S lhs, const ndarray_base<Rhs>& rhs) { return wise{[lhs](auto&& x) { return lhs - x; }, rhs.derived()}; }
+template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator-(const ndarray_base<Lhs>& lhs, S rhs) { return wise{scalar_op<std::minus<>, S, false>{{}, rhs}, lhs.derived()}; }
+template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator-(S lhs, const ndarray_base<Rhs>& rhs) { return wise{scalar_op<std::minus<>, S, true>{{}, lhs}, rhs.derived()}; }
 
-template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator*(const ndarray_base<Lhs>& lhs, S rhs) { return wise{[rhs](auto&& x) { return x * rhs; }, lhs.derived()}; }
-template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator*(S lhs, const ndarray_base<Rhs>& rhs) { return wise{[lhs](auto&& x) { return lhs * x; }, rhs.derived()}; }
+template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator*(const ndarray_base<Lhs>& lhs, S rhs) { return wise{scalar_op<std::multiplies<>, S, false>{{}, rhs}, lhs.derived()}; }
+template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator*(S lhs, const ndarray_base<Rhs>& rhs) { return wise{scalar_op<std::multiplies<>, S, true>{{}, lhs}, rhs.derived()}; }
 
-template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator/(const ndarray_base<Lhs>& lhs, S rhs) { return wise{[rhs](auto&& x) { return x / rhs; }, lhs.derived()}; }
-template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator/(S lhs, const ndarray_base<Rhs>& rhs) { return wise{[lhs](auto&& x) { return lhs / x; }, rhs.derived()}; }
+template < typename Lhs, typename S, typename = swise<S, Lhs> > constexpr auto operator/(const ndarray_base<Lhs>& lhs, S rhs) { return wise{scalar_op<std::divides<>, S, false>{{}, rhs}, lhs.derived()}; }
+template < typename Rhs, typename S, typename = swise<S, Rhs> > constexpr auto operator/(S lhs, const ndarray_base<Rhs>& rhs) { return wise{scalar_op<std::divides<>, S, true>{{}, lhs}, rhs.derived()}; }
 
 } // namespace ig
 
@@ -0,0 +1,116 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_NDARRAYSHAPE_H
+#define IG_MATH_NDARRAYSHAPE_H
+
+#include "imagine/math/basis.h"
+
+#include <array>
+#include <iterator>
+
+namespace ig {
+namespace nd {
+
+constexpr size_t max_dims = 8;
+
+// Inline shape
+// fixed-capacity sequence of extents (or strides) stored in place, array handles and expression nodes
+// copy their layout without allocating, ranks above the capacity are rejected
+template <size_t N = max_dims>
+class inline_shape {
+public:
+  using value_type      = size_t;
+  using size_type       = size_t;
+  using reference       = size_t&;
+  using const_reference = const size_t&;
+  using iterator        = size_t*;
+  using const_iterator  = const size_t*;
+
+  constexpr inline_shape() = default;
+  explicit inline_shape(size_t n, size_t value = 0) { assign(n, value); }
+  inline_shape(std::initializer_list<size_t> list) { assign(list.begin(), list.end()); }
+  template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+  inline_shape(It first, It last) { assign(first, last); }
+
+  auto size() const { return size_; }
+  auto empty() const { return !size_; }
+  static constexpr auto capacity() { return N; }
+
+  auto data() const { return data_; }
+  auto data()       { return data_; }
+  auto begin() const { return data_; }
+  auto begin()       { return data_; }
+  auto end() const { return data_ + size_; }
+  auto end()       { return data_ + size_; }
+
+  auto& operator[](size_t n) const { return data_[n]; }
+  auto& operator[](size_t n)       { return data_[n]; }
+  auto& front() const { return data_[0]; }
+  auto& front()       { return data_[0]; }
+  auto& back() const { return data_[size_ - 1]; }
+  auto& back()       { return data_[size_ - 1]; }
+
+  void clear() { size_ = 0; }
+  void resize(size_t n, size_t value = 0) {
+    reserve(n);
+    for (auto i = size_; i < n; ++i) data_[i] = value;
+    size_ = n;
+  }
+
+  void assign(size_t n, size_t value) {
+    reserve(n);
+    std::fill_n(data_, n, value);
+    size_ = n;
+  }
+
+  template <typename It>
+  void assign(It first, It last) {
+    reserve(size_t(std::distance(first, last)));
+    size_ = size_t(std::copy(first, last, data_) - data_);
+  }
+
+  auto& emplace_back(size_t value) {
+    reserve(size_ + 1);
+    return data_[size_++] = value;
+  }
+  void push_back(size_t value) { emplace_back(value); }
+  void pop_back() { --size_; }
+
+  bool operator==(const inline_shape& o) const { return std::equal(begin(), end(), o.begin(), o.end()); }
+  bool operator!=(const inline_shape& o) const { return !(*this == o); }
+
+private:
+  static void reserve(size_t n) {
+    if (n > N)
+      throw std::runtime_error{"[Ndarray] Rank " + std::to_string(n) + " exceeds the " + std::to_string(N) + " supported dimensions"};
+  }
+
+  size_t data_[N]{};
+  size_t size_ = 0;
+};
+
+// Static extents
+// shape and dense strides of arrays whose dimensions are known at compile time
+template <size_t... D>
+struct extents {
+  static constexpr size_t dims = sizeof...(D);
+  static constexpr size_t size = (D * ... * 1);
+  static constexpr std::array<size_t, dims> shape{D...};
+  static constexpr std::array<size_t, dims> strides = [] {
+    std::array<size_t, dims> s{};
+    size_t stride = 1, d = 0;
+    for (auto n : {D...}) {
+      s[d++] = stride;
+      stride *= n;
+    } return s;
+  }();
+};
+
+} // namespace nd
+} // namespace ig
+
+#endif // IG_MATH_NDARRAYSHAPE_H
@@ -70,6 +70,15 @@ public:
   template <typename... Id>
   decltype(auto) operator()(Id... ids)       { return impl(std::index_sequence_for<Id...>{}, ids...); }
 
+  static constexpr bool strided = true;
+  auto& source() const { return xpr_; }
+  auto offset() const { return off_; }
+
+  auto stepper() const { return strided_stepper{xpr_, off_, strides_}; }
+
+  auto ndbegin() const { return strided_iterator<view>{*this, 0}; }
+  auto ndend() const   { return strided_iterator<view>{*this, size_}; }
+
   decltype(auto) eval(size_t id) const {
     return eval_strided(
       [this](auto i) { return i < eff_; },
@@ -123,8 +132,175 @@ decltype(auto) eval_strided(
       re);
 }
 
+// Strided traversal
+// rows follow the first (fastest) dimension, the offset of the next row is carried from
+// the previous one through the multi-index instead of being rebuilt from the linear index
+template 
+< typename Shape, 
+  typename Strides >
+class strided_rows {
+public:
+  explicit strided_rows(const Shape& shape, const Strides& strides, size_t dims, size_t begin)
+    : shape_{shape}
+    , strides_{strides}
+    , index_(dims, 0)
+    , offset_{begin} {}
+
+  auto offset() const { return offset_; }
+  auto stride() const { return strides_[0]; }
+  auto length() const { return shape_[0]; }
+
+  // positions the cursor on a row counted in evaluation order
+  void seek(size_t row) {
+    offset_ -= std::inner_product(index_.begin(), index_.end(), strides_.begin(), size_t(0));
+    for (size_t d = 1; d < index_.size(); ++d) {
+      index_[d] = row % shape_[d];
+      row /= shape_[d];
+    } offset_ += std::inner_product(index_.begin(), index_.end(), strides_.begin(), size_t(0));
+  }
+
+  bool next() {
+    for (size_t d = 1; d < index_.size(); ++d) {
+      offset_ += strides_[d];
+      if (++index_[d] < shape_[d]) return true;
+      offset_ -= strides_[d] * shape_[d];
+      index_[d] = 0;
+    } return false;
+  }
+
+private:
+  const Shape& shape_;
+  const Strides& strides_;
+  nd::inline_shape<> index_;
+  size_t offset_;
+};
+
+// calls fn(offset, stride, length) on the rows [begin, end) of a strided expression, in evaluation order
+template 
+< typename Arr, 
+  typename Fn >
+void for_each_row(const Arr& arr, Fn&& fn, size_t begin = 0, size_t end = size_t(-1)) {
+  if (arr.size() == 0 || begin >= end) return;
+
+  strided_rows rows{arr.shape(), arr.strides(), arr.dims(), arr.offset()};
+  rows.seek(begin);
+  end = std::min(end, arr.size() / rows.length());
+  for (auto row = begin; row < end; ++row, rows.next()) 
+    fn(rows.offset(), rows.stride(), rows.length());
+}
+
+template <typename Arr>
+class strided_iterator {
+public:
+  using value_type = ndarray_t<Arr>;
+  using pointer    = value_type*;
+  using reference  = value_type&;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+
+  explicit strided_iterator(const Arr& arr, size_t i)
+    : arr_{arr}
+    , i_{i}
+    , j_{0}
+    , rows_{arr.shape(), arr.strides(), i < arr.size() ? arr.dims() : 0, arr.offset()} {}
+
+  auto& operator++() { 
+    ++i_;
+    if (++j_ == rows_.length()) {
+      j_ = 0;
+      rows_.next();
+    } return *this;
+  }
+
+  bool operator==(const strided_iterator& o) const
+  { return i_ == o.i_; }
+  bool operator!=(const strided_iterator& o) const
+  { return i_ != o.i_; }
+
+  auto operator*() const -> decltype(auto)
+  { return arr_.source().eval(rows_.offset() + j_ * rows_.stride()); }
+
+private:
+  const Arr& arr_;
+  size_t i_, j_;
+  strided_rows< std::decay_t<decltype(std::declval<const Arr&>().shape())>, std::decay_t<decltype(std::declval<const Arr&>().strides())> > rows_;
+};
+
+template <typename Xpr, typename Shp, typename Str>
+struct ndarray_traits
+<
+  domain<Xpr, Shp, Str>
+>
+{
+  using value_type = ndarray_t<Xpr>;
+};
+
+// Domain
+// arbitrary strided window over the linear index of an expression, element (i0, i1, ...) reads
+// offset + i0 * strides[0] + i1 * strides[1] + ..., zero strides repeat the source along a dimension
+// (reshapes, squeezes, splits and grids, see manipulation.h)
+template
+< typename x_,
+  typename sh_,
+  typename st_ >
+class domain : public ndarray_base< domain<x_, sh_, st_> > {
+public:
+  explicit domain(x_ xpr, const sh_& shape, const st_& strides, size_t offset = 0)
+    : xpr_{xpr}
+    , shape_{shape}
+    , strides_{strides}
+    , offset_{offset}
+    , size_{std::accumulate(shape_.begin(), shape_.end(), size_t(1), std::multiplies<>{})} {
+
+    assert(
+      !shape_.empty() &&
+      shape_.size() == strides_.size() && "Invalid ndarray domain");
+  }
+
+  auto size() const { return size_; }
+  auto dims() const { return shape_.size(); }
+  auto& shape() const   { return shape_; }
+  auto& strides() const { return strides_; }
+
+  template <typename... Id>
+  decltype(auto) operator()(Id... ids) const { return xpr_.eval(locate(ids...)); }
+  template <typename... Id>
+  decltype(auto) operator()(Id... ids)       { return xpr_.eval(locate(ids...)); }
+
+  static constexpr bool strided = true;
+  auto& source() const { return xpr_; }
+  auto offset() const { return offset_; }
+
+  auto stepper() const { return strided_stepper{xpr_, offset_, strides_}; }
+
+  auto ndbegin() const { return strided_iterator<domain>{*this, 0}; }
+  auto ndend() const   { return strided_iterator<domain>{*this, size_}; }
+
+  decltype(auto) eval(size_t id) const {
+    return eval_strided(
+      [this](auto i) { return i < dims() - 1; },
+      *this,
+       xpr_,
+       strides_,
+       id,
+       offset_);
+  }
+
+private:
+  template <typename... Id>
+  auto locate(Id... ids) const {
+    size_t is[] = {size_t(ids)...};
+    return std::inner_product(std::begin(is), std::end(is), strides_.begin(), offset_);
+  }
+
+  x_ xpr_;
+  sh_ shape_;
+  st_ strides_;
+  size_t offset_, size_;
+};
+
 // Range
-struct view_span 
+struct view_span
 {
   size_t begin = 0, end = -1, step = 1;
 };
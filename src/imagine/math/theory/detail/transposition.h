@@ -0,0 +1,166 @@
+/*
+ Imagine v0.1
+ [math]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_MATH_TRANSPOSITION_H
+#define IG_MATH_TRANSPOSITION_H
+
+#include "imagine/math/basis.h"
+#include "imagine/math/theory/simd_accel/intrinsics.h"
+
+namespace ig {
+
+// Transposition kernels
+// a block of width x width elements read by rows at src (stride lds) and written by rows at dst (stride ldd),
+// transposed in registers, width 1 means scalar only
+template <typename T>
+struct transpose_kernel {
+  static constexpr size_t width = 1;
+  static void block(T* dst, size_t, const T* src, size_t) { *dst = *src; }
+  static void prefetch(const T*) {}
+};
+
+#if defined(IG_X86) && defined(IG_AVX)
+template <>
+struct transpose_kernel<float> {
+  static constexpr size_t width = 8;
+  static void prefetch(const float* src) { _mm_prefetch(reinterpret_cast<const char*>(src), _MM_HINT_T0); }
+  static void block(float* dst, size_t ldd, const float* src, size_t lds) {
+    auto r0 = _mm256_loadu_ps(src),           r1 = _mm256_loadu_ps(src + lds);
+    auto r2 = _mm256_loadu_ps(src + 2 * lds), r3 = _mm256_loadu_ps(src + 3 * lds);
+    auto r4 = _mm256_loadu_ps(src + 4 * lds), r5 = _mm256_loadu_ps(src + 5 * lds);
+    auto r6 = _mm256_loadu_ps(src + 6 * lds), r7 = _mm256_loadu_ps(src + 7 * lds);
+
+    auto t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+    auto t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+    auto t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+    auto t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+
+    auto s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    auto s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    auto s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    auto s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm256_storeu_ps(dst,           _mm256_permute2f128_ps(s0, s4, 0x20));
+    _mm256_storeu_ps(dst + ldd,     _mm256_permute2f128_ps(s1, s5, 0x20));
+    _mm256_storeu_ps(dst + 2 * ldd, _mm256_permute2f128_ps(s2, s6, 0x20));
+    _mm256_storeu_ps(dst + 3 * ldd, _mm256_permute2f128_ps(s3, s7, 0x20));
+    _mm256_storeu_ps(dst + 4 * ldd, _mm256_permute2f128_ps(s0, s4, 0x31));
+    _mm256_storeu_ps(dst + 5 * ldd, _mm256_permute2f128_ps(s1, s5, 0x31));
+    _mm256_storeu_ps(dst + 6 * ldd, _mm256_permute2f128_ps(s2, s6, 0x31));
+    _mm256_storeu_ps(dst + 7 * ldd, _mm256_permute2f128_ps(s3, s7, 0x31));
+  }
+};
+
+template <>
+struct transpose_kernel<double> {
+  static constexpr size_t width = 4;
+  static void prefetch(const double* src) { _mm_prefetch(reinterpret_cast<const char*>(src), _MM_HINT_T0); }
+  static void block(double* dst, size_t ldd, const double* src, size_t lds) {
+    auto r0 = _mm256_loadu_pd(src),           r1 = _mm256_loadu_pd(src + lds);
+    auto r2 = _mm256_loadu_pd(src + 2 * lds), r3 = _mm256_loadu_pd(src + 3 * lds);
+
+    auto t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+    auto t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+
+    _mm256_storeu_pd(dst,           _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + ldd,     _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+  }
+};
+#elif defined(IG_X86) && defined(IG_SSE)
+template <>
+struct transpose_kernel<float> {
+  static constexpr size_t width = 4;
+  static void prefetch(const float* src) { _mm_prefetch(reinterpret_cast<const char*>(src), _MM_HINT_T0); }
+  static void block(float* dst, size_t ldd, const float* src, size_t lds) {
+    auto r0 = _mm_loadu_ps(src),           r1 = _mm_loadu_ps(src + lds);
+    auto r2 = _mm_loadu_ps(src + 2 * lds), r3 = _mm_loadu_ps(src + 3 * lds);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(dst,           r0);
+    _mm_storeu_ps(dst + ldd,     r1);
+    _mm_storeu_ps(dst + 2 * ldd, r2);
+    _mm_storeu_ps(dst + 3 * ldd, r3);
+  }
+};
+
+template <>
+struct transpose_kernel<double> {
+  static constexpr size_t width = 2;
+  static void prefetch(const double* src) { _mm_prefetch(reinterpret_cast<const char*>(src), _MM_HINT_T0); }
+  static void block(double* dst, size_t ldd, const double* src, size_t lds) {
+    auto r0 = _mm_loadu_pd(src), r1 = _mm_loadu_pd(src + lds);
+    _mm_storeu_pd(dst,       _mm_unpacklo_pd(r0, r1));
+    _mm_storeu_pd(dst + ldd, _mm_unpackhi_pd(r0, r1));
+  }
+};
+#endif
+
+// edge of the square tiles walked by the transpositions, a source and a destination tile stay in L2 together
+template <typename T>
+constexpr size_t transpose_tile = std::max<size_t>(transpose_kernel<T>::width, 1024 / sizeof(T));
+
+// dst[j * ldd + i] = src[i * lds + j] for i < rows and j < cols, tile by tile, destination rows are filled 
+// block after block while the source rows a few blocks ahead are prefetched
+template <typename T>
+void transpose_into(T* dst, size_t ldd, const T* src, size_t lds, size_t rows, size_t cols) {
+  using kernel = transpose_kernel<T>;
+  constexpr auto w = kernel::width, tile = transpose_tile<T>, ahead = 2 * w;
+
+  for (size_t jb = 0; jb < cols; jb += tile)
+    for (size_t ib = 0; ib < rows; ib += tile) {
+      auto ie = std::min(rows, ib + tile);
+      auto je = std::min(cols, jb + tile);
+
+      auto j = jb;
+      for (; j + w <= je; j += w) {
+        auto i = ib;
+        for (; i + w <= ie; i += w) {
+          if (i + ahead + w <= ie)
+            for (size_t k = 0; k < w; ++k) kernel::prefetch(src + (i + ahead + k) * lds + j);
+          kernel::block(dst + j * ldd + i, ldd, src + i * lds + j, lds);
+        }
+        for (; i < ie; ++i)
+          for (size_t k = 0; k < w; ++k) dst[(j + k) * ldd + i] = src[i * lds + j + k];
+      }
+      for (; j < je; ++j)
+        for (auto i = ib; i < ie; ++i) dst[j * ldd + i] = src[i * lds + j];
+    }
+}
+
+// in-place transposition of the n x n matrix at data (stride ld), mirrored block pairs are swapped through
+// a register-transposed copy and diagonal blocks are transposed on themselves
+template <typename T>
+void transpose_square(T* data, size_t n, size_t ld) {
+  using kernel = transpose_kernel<T>;
+  constexpr auto w = kernel::width;
+  T a[w * w], b[w * w];
+
+  auto blocks = n - n % w;
+  for (size_t i = 0; i < blocks; i += w) {
+    kernel::block(a, w, data + i * ld + i, ld);
+    for (size_t k = 0; k < w; ++k) std::copy_n(a + k * w, w, data + (i + k) * ld + i);
+
+    for (auto j = i + w; j < blocks; j += w) {
+      auto upper = data + i * ld + j;
+      auto lower = data + j * ld + i;
+      kernel::block(a, w, upper, ld);
+      kernel::block(b, w, lower, ld);
+      for (size_t k = 0; k < w; ++k) {
+        std::copy_n(a + k * w, w, lower + k * ld);
+        std::copy_n(b + k * w, w, upper + k * ld);
+      }
+    }
+  }
+
+  // remaining rows and columns past the last full block
+  for (auto i = blocks; i < n; ++i)
+    for (size_t j = 0; j < i; ++j) std::swap(data[i * ld + j], data[j * ld + i]);
+}
+
+} // namespace ig
+
+#endif // IG_MATH_TRANSPOSITION_H
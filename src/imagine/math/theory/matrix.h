@@ -12,6 +12,8 @@
 #include "imagine/math/theory/detail/matrix/col.h"
 #include "imagine/math/theory/detail/matrix/row.h"
 #include "imagine/math/theory/detail/matrix/diag.h"
+#include "imagine/math/theory/detail/matrix/map.h"
+#include "imagine/math/theory/detail/matrix/noalias.h"
 
 #include "imagine/math/theory/detail/matrix/type/symm.h"
 #include "imagine/math/theory/detail/matrix/type/triang.h"
@@ -74,8 +76,11 @@ public:
         n} {}
 
   template <typename Mat>
-  matrix(const matrix_base<Mat>& o) : matrix{o, std::integral_constant<bool, immutable>{}}
-  { eval(*this, o, data_); }
+  matrix(const matrix_base<Mat>& o) : matrix{o, std::integral_constant<bool, immutable>{}} {
+    if constexpr (is_matrix_prod<Mat>::value) o.derived().eval_into(*this, 1, 0);
+    else 
+      eval(*this, o, data_);
+  }
 
   template <typename Mat> matrix(const matrix_base<Mat>& o, std::true_type) {}
   template <typename Mat> matrix(const matrix_base<Mat>& o, std::false_type)
@@ -86,12 +91,17 @@ public:
 
   matrix(const matrix& o) : data_{o.derived().data_} {}
 
+  template <typename Mat>
+  auto operator=(const matrix_base<Mat>& o) -> matrix&;
+
   auto rows() const { return data_.rows_impl(); }
   auto cols() const { return data_.cols_impl(); }
 
   auto buffer() const { return data_.d.data(); }
   auto buffer()       { return data_.d.data(); }
 
+  auto fingerprint() const { return ig::fingerprint(buffer(), matrix::size(), std::array<size_t, 2>{rows(), cols()}); }
+
   auto operator()(size_t row, size_t col) const -> const value_type&;
   auto operator()(size_t row, size_t col) -> value_type&;
 
@@ -99,6 +109,8 @@ public:
   auto operator[](size_t n) -> value_type&;
 
   auto make_eye() -> matrix&;
+  template < bool X = (m_ == n_), typename = std::enable_if_t<X> >
+  auto make_transpose() -> matrix&;
 
   template < bool X = immutable, typename = std::enable_if_t<X> >
   static auto eye()         { return matrix{ }.make_eye(); }
@@ -109,7 +121,7 @@ public:
 private:
   using container_type = std::conditional_t
     < hybrid,
-      std::vector<value_type>,
+      std::vector<value_type, allocator<value_type>>,
       std::array <value_type, m_ * n_>
     >;
 
@@ -172,6 +184,23 @@ auto matrix<t_, m_, n_>::operator[](size_t n) -> value_type& {
   return data_.d[n];
 }
 
+// Assignment, expressions of the same dimensions are evaluated in the current storage of dynamic matrices
+// (products included, see matrix_prod), the others and those reading this matrix out of place through a new one,
+// static matrices are always evaluated on the stack first
+template
+< typename t_,
+  size_t m_,
+  size_t n_ >
+template <typename Mat>
+auto matrix<t_, m_, n_>::operator=(const matrix_base<Mat>& o) -> matrix& {
+  if (immutable || rows() != o.rows() || cols() != o.cols() || aliased(o, matrix_region_of(*this))) {
+    matrix ev{o};
+    data_ = std::move(ev.data_);
+  } else 
+    eval_helper(*this, o);
+  return *this;
+}
+
 // Eye (Identity)
 template
 < typename t_,
@@ -183,6 +212,21 @@ auto matrix<t_, m_, n_>::make_eye() -> matrix& {
   return *this;
 }
 
+// Transpose in place, square matrices are transposed on themselves and dynamic ones through a copy otherwise
+template
+< typename t_,
+  size_t m_,
+  size_t n_ >
+template <bool, typename>
+auto matrix<t_, m_, n_>::make_transpose() -> matrix& {
+  if (matrix::square()) transpose_square(buffer(), rows(), cols());
+  else if constexpr (dynamic) {
+    auto src = data_.d;
+    transpose_into(buffer(), rows(), src.data(), cols(), rows(), cols());
+    std::swap(data_.m, data_.n);
+  } return *this;
+}
+
 } // namespace ig
 
 #endif // IG_MATH_MATRIX_H
@@ -14,40 +14,43 @@
 #include "imagine/math/theory/detail/ndarray/expr/wise.h"
 
 #include "imagine/math/theory/detail/ndarray/allocator/dense.h"
+#include "imagine/math/theory/detail/ndarray/allocator/mapped.h"
 #include "imagine/math/theory/detail/ndarray/allocator/sparse.h"
+#include "imagine/math/theory/detail/ndarray/allocator/blocked.h"
 
 namespace ig {
 
-template <typename T,  size_t... D>
+template <typename S>
 struct ndarray_traits
 <
-  ndarray<T, D...>
+  basic_ndarray<S>
 >
 {
-  using value_type = T;
+  using value_type = typename S::value_type;
 };
 
-template <typename t_, size_t... d_>
-class ndarray : public ndarray_base< ndarray<t_, d_...> > {
+template <typename s_>
+class basic_ndarray : public ndarray_base< basic_ndarray<s_> > {
 public:
-  using value_type = t_;
-  static constexpr auto dynamic = !sizeof...(d_);
+  using value_type = typename s_::value_type;
+  using storage_type = s_;
+  static constexpr auto dynamic = s_::dynamic;
   static constexpr auto immutable = !dynamic;
 
-  constexpr ndarray() = default;
+  constexpr basic_ndarray() = default;
 
   template
   < typename Arg,
     typename... Args,
     typename = std::enable_if_t<!is_ndarray<Arg>::value> >
-  constexpr explicit ndarray(Arg&& arg, Args&&... args) : storage_{arg, args...} {}
+  constexpr explicit basic_ndarray(Arg&& arg, Args&&... args) : storage_{arg, args...} {}
 
   template <typename Arr>
-  ndarray(const ndarray_base<Arr>& o) : ndarray{o, o.shape(), std::integral_constant<bool, immutable>{}}
+  basic_ndarray(const ndarray_base<Arr>& o) : basic_ndarray{o, o.shape(), std::integral_constant<bool, immutable>{}}
   { eval_helper(*this, o); }
 
-  template <typename Arr, typename Shape> ndarray(const ndarray_base<Arr>& o, const Shape& shape, std::true_type) : storage_{} {}
-  template <typename Arr, typename Shape> ndarray(const ndarray_base<Arr>& o, const Shape& shape, std::false_type)
+  template <typename Arr, typename Shape> basic_ndarray(const ndarray_base<Arr>& o, const Shape& shape, std::true_type) : storage_{} {}
+  template <typename Arr, typename Shape> basic_ndarray(const ndarray_base<Arr>& o, const Shape& shape, std::false_type)
   : storage_{shape} {}
 
   auto size() const { return storage_.size(); }
@@ -58,6 +61,12 @@ public:
   auto data() const { return storage_.buffer(); }
   auto data()       { return storage_.buffer(); }
 
+  auto fingerprint() const { 
+    if constexpr (is_dense_leaf<basic_ndarray>::value) return ig::fingerprint(data(), size(), shape());
+    else 
+      return ndarray_base<basic_ndarray>::fingerprint();
+  }
+
   auto operator->() const { return &storage_; }
   auto operator->()       { return &storage_; }
 
@@ -69,10 +78,41 @@ public:
   decltype(auto) eval(size_t id)       
   { return storage_(id); }
 
+  static constexpr bool packed = is_dense_leaf<basic_ndarray>::value && nd_packet<value_type>::width > 1;
+  auto eval_packet(size_t id) const 
+  { return nd_packet<value_type>::load(data() + id); }
+
+  auto stepper() const { 
+    if constexpr (is_dense_leaf<basic_ndarray>::value) return dense_stepper<value_type>{data(), strides().data()};
+    else 
+      return linear_stepper<basic_ndarray>{*this};
+  }
+
+  // sparse arrays scatter their non-zeros into dense destinations, blocked ones their runs
+  static constexpr bool direct = !is_dense_leaf<basic_ndarray>::value;
+  template <typename T>
+  void eval_into(T* dst, const nd::eval_policy& policy) const {
+    if constexpr (is_blocked_leaf<basic_ndarray>::value) storage_.scatter(dst, policy);
+    else {
+      std::fill_n(dst, size(), T(0));
+      storage_.for_each([dst](auto id, auto v) { dst[id] = v; });
+    }
+  }
+
   template <typename Arr>
-  auto& operator=(const ndarray_base<Arr>&  o) { return eval_helper(*this, o); }
+  auto& operator=(const ndarray_base<Arr>&  o) { return assign(o, nd::policy()); }
+  template <typename Arr>
+  auto& operator=(      ndarray_base<Arr>&& o) { return assign(o, nd::policy()); }
+
+  // assignment under a per-call evaluation policy, e.g. nd::sequential,
+  // right-hand sides reading this array out of place are materialized first, but for square transposes
   template <typename Arr>
-  auto& operator=(      ndarray_base<Arr>&& o) { return eval_helper(*this, o); }
+  auto& assign(const ndarray_base<Arr>& o, const nd::eval_policy& policy) {
+    if (!nd::aliased(o.derived(), *this)) eval_helper(*this, o, policy);
+    else if (!square_transpose(o.derived()))
+      eval_helper(*this, basic_ndarray< nd::dense< nd::dynamic_alloc<value_type> > >{o}, policy);
+    return *this;
+  }
 
   template <typename Shape> 
   static auto identity(Shape&& shape);
@@ -82,27 +122,91 @@ protected:
   auto layout(Id... ids) const
   { return storage_.access(ids...); }
 
+  // transposes of this square array are run in place
+  template <typename Arr>
+  bool square_transpose(const Arr& o) {
+    if constexpr (is_transpose<Arr>::value && is_dense_leaf<basic_ndarray>::value) {
+      if (static_cast<const void*>(&o.source()) != this || dims() != 2 || shape()[0] != shape()[1]) return false;
+      transpose_square(data(), shape()[0], shape()[0]);
+      return true;
+    } else 
+      return false;
+  }
+
 protected:
-  nd::dense
-  < 
-    std::conditional_t
-    < dynamic,
-      nd::dynamic_alloc<value_type>,
-      nd:: static_alloc<value_type, d_...>
-    >
-  > storage_;
+  s_ storage_;
 };
 
 template 
-<typename t_, size_t... d_>
+<typename s_>
 template 
 <typename Shape>
-auto ndarray<t_, d_...>::identity(Shape&& shape) { 
-  ndarray I{shape};
+auto basic_ndarray<s_>::identity(Shape&& shape) { 
+  basic_ndarray I{shape};
   for (auto it = I.begin(); it < I.end(); it += I.strides().back() + 1) (*it) = 1;
   return I; 
 }
 
+// dense arrays, dynamic when no dimension is given
+template <typename T, size_t... D>
+using ndarray =
+  basic_ndarray
+  < nd::dense
+    < std::conditional_t
+      < !sizeof...(D),
+        nd::dynamic_alloc<T>,
+        nd:: static_alloc<T, D...>
+      >
+    >
+  >;
+
+// dense arrays aligned on cache lines and left uninitialized on construction, 
+// Pages = transparent_pages or huge_pages backs large ones with huge pages
+template <typename T, typename Pages = current_pages>
+using aligned_ndarray = basic_ndarray< nd::dense< nd::aligned_alloc<T, Pages> > >;
+
+// dense arrays over external memory (mapped files, shared segments)
+template <typename T> using ndarray_map = basic_ndarray< nd::dense< nd::extern_alloc<T> > >;
+
+// dense arrays backed by an array file, larger than memory if needed
+template <typename T> using ndarray_file = basic_ndarray< nd::dense< nd::mmap_alloc<T> > >;
+
+// arrays stored by bricks of Edge elements along each dimension, or along a Z-order curve,
+// neighborhoods in every dimension stay within a few cache lines or pages
+template <typename T, size_t Edge = 16> using tiled_ndarray  = basic_ndarray< nd::blocked< T, nd::tiled_order<Edge> > >;
+template <typename T>                   using morton_ndarray = basic_ndarray< nd::blocked< T, nd::morton_order > >;
+
+// sparse arrays, non-zeros stored in a nd::coo, nd::csr, nd::csc or nd::csf layout
+template <typename T, template <typename> class Format = nd::csf> 
+using sparse_ndarray = basic_ndarray< Format<T> >;
+
+// expressions are materialized before hashing
+template <typename D>
+auto ndarray_base<D>::fingerprint() const -> hash128
+{ return ndarray< std::remove_cv_t<value_type> >{derived()}.fingerprint(); }
+
+// in-place updates as wise expressions over the array itself, copied first only when nd::aliased
+template <typename D>
+template <typename Op>
+auto& ndarray_base<D>::update(widened_t<value_type> value, Op op) {
+  eval_helper(derived(), wise{scalar_op<Op, widened_t<value_type>, false>{{}, value}, derived()});
+  return derived();
+}
+
+template <typename D>
+template 
+< typename Arr,
+  typename Op >
+auto& ndarray_base<D>::update(const ndarray_base<Arr>& arr, Op op) {
+  if (nd::aliased(arr.derived(), derived())) 
+    eval_helper(derived(), wise{op, derived(), ndarray< std::remove_cv_t< ndarray_t<Arr> > >{arr}});
+  else 
+    eval_helper(derived(), wise{op, derived(), arr.derived()});
+  return derived();
+}
+
 } // namespace ig
 
+#include "imagine/math/theory/detail/ndarray/action/reduction.h"
+
 #endif // IG_MATH_NDARRAY_H
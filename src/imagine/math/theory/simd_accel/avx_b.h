@@ -23,11 +23,7 @@ struct bool8 {
   operator       __m256&()       { return d.v; }
   operator const __m256i() const { return _mm256_castps_si256(d.v); }
 
-  simd_data
-  < __m256,
-    int[8],
-    32
-  > d;
+  union { __m256 v; alignas(32) int p[8]; } d;
 };
 
 namespace
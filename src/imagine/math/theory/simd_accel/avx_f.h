@@ -28,11 +28,7 @@ struct float8 {
   operator const __m256&() const { return d.v; }
   operator       __m256&()       { return d.v; }
 
-  simd_data
-  < __m256,
-    float[8],
-    32
-  > d;
+  union { __m256 v; alignas(32) float p[8]; } d;
 };
 
 namespace
@@ -30,11 +30,7 @@ struct int8 {
   operator       __m256i&()       { return d.v; }
   operator const __m256  () const { return _mm256_castsi256_ps(d.v); }
 
-  simd_data
-  < __m256i,
-    int[8],
-    32
-  > d;
+  union { __m256i v; alignas(32) int p[8]; } d;
 };
 
 namespace
@@ -24,6 +24,17 @@
 # define IG_PACKET_WIDE  1
 #endif
 
+// conversion and wide instruction sets, used by dedicated kernels only (packets stay on AVX and SSE)
+#if defined(__F16C__)
+# define IG_F16C
+#endif
+#if defined(__FMA__)
+# define IG_FMA
+#endif
+#if defined(__AVX512F__)
+# define IG_AVX512
+#endif
+
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -83,12 +94,6 @@ inline auto ctz_f(size_t& v) {
   return i;
 }
 
-template
-< typename Simd,
-  typename Plain,
-  uint32_t Align >
-struct simd_data { union { Simd v; alignas(Align) Plain p; }; };
-
 } // namespace ig
 
 #if defined(IG_X86)
@@ -23,11 +23,7 @@ struct bool4 {
   operator       __m128&()       { return d.v; }
   operator const __m128i() const { return _mm_castps_si128(d.v); }
 
-  simd_data
-  < __m128,
-    int[4],
-    16
-  > d;
+  union { __m128 v; alignas(16) int p[4]; } d;
 };
 
 namespace
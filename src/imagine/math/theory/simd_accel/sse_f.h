@@ -28,11 +28,7 @@ struct float4 {
   operator const __m128&() const { return d.v; }
   operator       __m128&()       { return d.v; }
 
-  simd_data
-  < __m128,
-    float[4],
-    16
-  > d;
+  union { __m128 v; alignas(16) float p[4]; } d;
 };
 
 namespace
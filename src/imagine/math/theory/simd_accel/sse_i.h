@@ -30,11 +30,7 @@ struct int4 {
   operator       __m128i&()       { return d.v; }
   operator const __m128  () const { return _mm_castsi128_ps(d.v); }
 
-  simd_data
-  < __m128i,
-    int[4],
-    16
-  > d;
+  union { __m128i v; alignas(16) int p[4]; } d;
 };
 
 namespace
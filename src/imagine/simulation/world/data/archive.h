@@ -0,0 +1,100 @@
+/*
+ Imagine v0.1
+ [bridge]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_SIMULATION_ARCHIVE_H
+#define IG_SIMULATION_ARCHIVE_H
+
+#include "imagine/core/settings/serialize.h"
+
+#include "imagine/math/theory/matrix.h"
+#include "imagine/math/theory/ndarray.h"
+
+#include "imagine/math/geom/representation/mesh.h"
+
+namespace ig {
+
+// binary archives of library objects
+// loading maps the archive and builds objects directly over its pages (copy-on-write, no parsing)
+
+template <typename Alloc>
+size_t save(archive_writer& ar, const std::string& name, const basic_ndarray< nd::dense<Alloc> >& arr)
+{ return ar.write(name, section_kind::ndarray, arr.data(), arr.size(), arr.shape()); }
+
+template <typename Arr>
+size_t save(archive_writer& ar, const std::string& name, const ndarray_base<Arr>& arr)
+{ return save(ar, name, ndarray< std::remove_cv_t<ndarray_t<Arr>> >{arr}); }
+
+template <typename T>
+auto load_ndarray(const archive& ar, const std::string& name) {
+  auto i = ar.find(name, section_kind::ndarray);
+  if (i == archive::npos)
+    throw std::runtime_error{"[Archive] No ndarray section named " + name};
+
+  auto& s = ar[i];
+  auto data = ar.data<T>(i);
+  if (!s.spans(s.dims))
+    throw std::runtime_error{"[Archive] Section " + s.label() + " has a shape inconsistent with its payload"};
+  return ndarray_map<T>{std::vector<size_t>(s.shape, s.shape + s.dims), data, ar.holder()};
+}
+
+template <typename T, size_t M, size_t N>
+size_t save(archive_writer& ar, const std::string& name, const matrix<T, M, N>& mat)
+{ return ar.write(name, section_kind::matrix, mat.buffer(), mat.size(), std::array<size_t, 2>{mat.rows(), mat.cols()}); }
+
+template <typename Mat>
+size_t save(archive_writer& ar, const std::string& name, const matrix_base<Mat>& mat)
+{ return save(ar, name, matrix< matrix_t<Mat> >{mat}); }
+
+template <typename T>
+auto load_matrix(const archive& ar, const std::string& name) {
+  auto i = ar.find(name, section_kind::matrix);
+  if (i == archive::npos)
+    throw std::runtime_error{"[Archive] No matrix section named " + name};
+
+  auto& s = ar[i];
+  auto data = ar.data<T>(i);
+  if (!s.spans(2))
+    throw std::runtime_error{"[Archive] Section " + s.label() + " has a shape inconsistent with its payload"};
+  return matrix_map<T>{data, s.shape[0], s.shape[1], ar.holder()};
+}
+
+// mesh sections
+// faces and vertices are stored as two sections sharing the same name
+struct mesh_map {
+  section_view<const mesh_s::face> faces;
+  section_view<const vertex> vertices;
+  std::shared_ptr<const void> holder;
+
+  auto to_mesh() const {
+    mesh_s m;
+    m.faces.assign(faces.begin(), faces.end());
+    m.vertices.assign(vertices.begin(), vertices.end());
+    return m;
+  }
+};
+
+inline size_t save(archive_writer& ar, const std::string& name, const mesh_s& mesh) {
+  static_assert(std::is_standard_layout_v<vertex>, "Mesh vertices must be standard layout to be archived");
+  ar.write(name, section_kind::mesh_faces, mesh.faces.data(), mesh.faces.size(), std::array<size_t, 1>{mesh.faces.size()});
+  return 
+  ar.write(name, section_kind::mesh_vertices, mesh.vertices.data(), mesh.vertices.size(), std::array<size_t, 1>{mesh.vertices.size()});
+}
+
+inline auto load_mesh(const archive& ar, const std::string& name) {
+  auto f = ar.find(name, section_kind::mesh_faces);
+  auto v = ar.find(name, section_kind::mesh_vertices);
+  if (f == archive::npos || v == archive::npos)
+    throw std::runtime_error{"[Archive] No mesh sections named " + name};
+
+  return mesh_map{
+    ar.view<const mesh_s::face>(f),
+    ar.view<const vertex>(v),
+    ar.holder()};
+}
+
+} // namespace ig
+
+#endif // IG_SIMULATION_ARCHIVE_H
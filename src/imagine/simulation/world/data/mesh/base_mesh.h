@@ -8,6 +8,8 @@
 #define IG_SIMULATION_BASE_MESH_H
 
 #include "imagine/simulation/world/data/bridge.h"
+#include "imagine/core/mem/resource.h"
+
 #include <unordered_map>
 
 namespace ig {
@@ -15,7 +17,8 @@ namespace ig {
 struct base_mesh {
   struct vert { int32_t p, t, n; };
   struct face { size_t index, count; };
-  struct pattern { std::vector<face> faces; std::vector<vert> verts; };
+  template <typename T> using scratch = std::vector<T, allocator<T>>;
+  struct pattern { scratch<face> faces; scratch<vert> verts; };
 
   base_mesh()
     : current (0)
@@ -25,7 +28,7 @@ struct base_mesh {
   template <typename VertexGen> auto generate_mesh(const pattern& src, VertexGen&& vg) const;
 
   uint32_t current;
-  std::vector<pattern> patterns;
+  scratch<pattern> patterns;
 };
 
 inline auto base_mesh::add_pattern() -> pattern& {
@@ -43,14 +46,18 @@ auto base_mesh::generate_mesh(const pattern& src, VertexGen&& vg) const {
            lhs.n == rhs.n;
   };
 
-  std::unordered_map<vert, size_t, decltype(hash), decltype(cmpt)> vertices{
+  std::unordered_map<vert, size_t, decltype(hash), decltype(cmpt), allocator<std::pair<const vert, size_t>>> vertices{
     src.verts.size(),
     hash,
     cmpt};
 
   auto mesh = std::make_unique<mesh_s>();
+  mesh->faces.reserve(src.faces.size());
+  mesh->vertices.reserve(src.verts.size());
+
+  scratch<uint32_t> face_ids;
   for (auto& face : src.faces) {
-    std::vector<uint32_t> face_ids(face.count);
+    face_ids.resize(face.count);
     for (size_t i = 0; i < face_ids.size(); ++i) {
       auto [vertex, ins] = vertices.try_emplace(src.verts[face.index + i], vertices.size());
       if (ins)
@@ -6,6 +6,7 @@
 
 #include "imagine/simulation/world/data/mesh/obj.h"
 #include "imagine/core/log.h"
+#include "imagine/core/mem/arena.h"
 
 #include <cctype>
 
@@ -14,12 +15,12 @@ namespace detail {
 
 struct obj_src : public base_mesh {
   
-  std::vector<vec3> p;
-  std::vector<vec2> t;
-  std::vector<vec3> n;
+  scratch<vec3> p;
+  scratch<vec2> t;
+  scratch<vec3> n;
 
   template <typename T>
-  auto vertex(int32_t id, const std::vector<T>& components) {
+  auto vertex(int32_t id, const scratch<T>& components) {
     if (!id) return T{};
     else {
       return id > 0
@@ -76,6 +77,19 @@ void parse_face(obj_src::pattern* pattern, std::string_view line, size_t face_co
 }
 
 obj obj_i_impl(std::istream& stream, const mesh_bridge::parameters&) {
+  // parsing scratch lives in an arena pre-sized from the stream length (default size for non-seekable streams)
+  // generated meshes use the regular heap and outlive it
+  std::streamoff length = 0;
+  auto begin = stream.tellg();
+  if (begin != -1 && stream.seekg(0, std::ios::end)) {
+    length = std::max<std::streamoff>(stream.tellg() - begin, 0);
+    stream.seekg(begin);
+  } else
+    stream.clear();
+
+  arena scratch{std::max<size_t>(2 * length, 1 << 16)};
+  resource_scope scope{scratch};
+
   obj_src src;
   obj_src::pattern* curr = &src.add_pattern();
 
@@ -0,0 +1,39 @@
+/*
+ Imagine v0.1
+ [bridge]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#ifndef IG_SIMULATION_SHARED_H
+#define IG_SIMULATION_SHARED_H
+
+#include "imagine/core/net/distribute.h"
+
+#include "imagine/math/theory/ndarray.h"
+
+namespace ig {
+
+// ndarrays over shared memory
+// maps hold a reference on the segment, so an ndarray_map outlives the shared_array it was built from
+
+template <typename T>
+auto map(const shared_array<T>& arr) 
+{ return ndarray_map<T>{arr.shape(), const_cast<T*>(arr.data()), arr.holder()}; }
+
+template <typename T>
+auto map(const shared_handle& h) 
+{ return map(shared_array<T>::attach(h)); }
+
+template <typename Arr>
+auto share(const ndarray_base<Arr>& arr) {
+  using value_type = std::remove_cv_t<ndarray_t<Arr>>;
+
+  shared_array<value_type> res{arr.shape()};
+  auto dst = map(res);
+  dst = arr;
+  return res;
+}
+
+} // namespace ig
+
+#endif // IG_SIMULATION_SHARED_H
@@ -0,0 +1,84 @@
+/*
+ Imagine v0.1
+ [test]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "scenario.h"
+#include "imagine/simulation/world/data/archive.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace ig;
+
+namespace {
+
+// rewrites the header or the first section of an archive in place
+template <typename Fn>
+void patch(const std::string& path, Fn&& fn) {
+  std::fstream f{path, std::ios::in | std::ios::out | std::ios::binary};
+  archive_header h{};
+  f.read(reinterpret_cast<char*>(&h), sizeof(h));
+
+  archive_section s{};
+  auto table = h.table;
+  f.seekg(table);
+  f.read(reinterpret_cast<char*>(&s), sizeof(s));
+
+  fn(h, s);
+  f.seekp(table);
+  f.write(reinterpret_cast<const char*>(&s), sizeof(s));
+  f.seekp(0);
+  f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+}
+
+void write(const std::string& path) {
+  archive_writer w{path};
+  save(w, "values", ndarray<float>(std::vector<size_t>{4, 3}));
+  save(w, "mat", matrix<float>(2, 3));
+  w.close();
+}
+
+} // namespace
+
+int main() {
+  auto path = test::temporary("archive.igba");
+
+  write(path);
+  {
+    archive ar{path};
+    auto values = load_ndarray<float>(ar, "values");
+    IG_EXPECT(values.shape()[0] == 4 && values.shape()[1] == 3);
+    IG_EXPECT(load_matrix<float>(ar, "mat").rows() == 2);
+    IG_EXPECT_THROW(load_matrix<double>(ar, "mat"), std::runtime_error);
+  }
+
+  // shapes which do not describe their payload
+  patch(path, [](auto&, auto& s) { s.shape[0] = 1000; });
+  IG_EXPECT_THROW(load_ndarray<float>(archive{path}, "values"), std::runtime_error);
+
+  write(path);
+  patch(path, [](auto&, auto& s) { s.shape[0] = s.shape[1] = uint64_t(1) << 32; });
+  IG_EXPECT_THROW(load_ndarray<float>(archive{path}, "values"), std::runtime_error);
+
+  // names filling their storage
+  write(path);
+  patch(path, [](auto&, auto& s) { std::fill(std::begin(s.name), std::end(s.name), 'n'); s.shape[0] = 1000; });
+  {
+    archive ar{path};
+    IG_EXPECT(ar[0].label() == std::string(sizeof(ar[0].name), 'n'));
+  }
+
+  // offsets whose bounds wrap around
+  write(path);
+  patch(path, [](auto& h, auto&) { h.table = uint64_t(-64); });
+  IG_EXPECT_THROW(archive{path}, std::runtime_error);
+
+  write(path);
+  patch(path, [](auto&, auto& s) { s.offset = uint64_t(-64); s.bytes = 128; });
+  IG_EXPECT_THROW(archive{path}, std::runtime_error);
+
+  std::remove(path.c_str());
+  return test::result();
+}
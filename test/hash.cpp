@@ -0,0 +1,60 @@
+/*
+ Imagine v0.1
+ [test]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "scenario.h"
+#include "imagine/core/settings/serialize.h"
+
+#include <vector>
+
+using namespace ig;
+
+namespace {
+
+struct known { size_t size; uint64_t lo, hi, seeded; };
+
+// values of the scalar path (built without SSE2 and AVX2), over bytes i * 131 + 7, the vector paths must give
+// the same ones whatever the instruction set and optimization level, lengths cross the short/long threshold (256)
+// and the blocks of 1024 bytes
+constexpr known answers[] = {
+  {0, 0x0409638ee2bde459ull, 0x8b1f22c6ae42a10full, 0xb793abbd5dba9c91ull},
+  {1, 0xfddeeeea8cc2709cull, 0x8a9d1eaf96955820ull, 0x811e0ca831ac02adull},
+  {3, 0x8e4fbcba74db6389ull, 0xff988c700409cf8full, 0xc9055bd487a562d7ull},
+  {4, 0xe51e02146ebec632ull, 0xc82fc7ec5ff37538ull, 0x39c8508d786523ebull},
+  {8, 0x6ad2fe40e65970edull, 0x1396ad48f64d8579ull, 0xa37ac37f744d8a77ull},
+  {16, 0x47340008ff15ca56ull, 0xbd03a593cedbd9ffull, 0xba7e95f8e82439c3ull},
+  {17, 0x8700d4e8fbdc902bull, 0xce6ba990000ece6eull, 0x459fb74fe00130e9ull},
+  {48, 0xb61c237f7239a6efull, 0x63a326af0e5f77b4ull, 0x6a64dd2d298240ceull},
+  {49, 0x601195ce2f825428ull, 0x21d8180889d086c6ull, 0xd01cf8e82f16eae1ull},
+  {100, 0xa013c973ca2ff6c6ull, 0xf00f9358db027801ull, 0x5d9888f879d6afafull},
+  {256, 0x324212f8c03583baull, 0x538e94044c45ebf8ull, 0x4a2f4acabdaa9740ull},
+  {257, 0xdd1b746f678ec6a5ull, 0x7a145ac550cc4220ull, 0x0079bf1624a211dfull},
+  {300, 0x0ed5b318ea071996ull, 0x8b3e6a269fb65c1bull, 0x650d847139f9f02aull},
+  {1023, 0x1b357cc888e3c18bull, 0x24b42ef0b0ae77f3ull, 0x2df205afcc70e287ull},
+  {1024, 0x573b7069fe2c23e3ull, 0x8470a97f22ae9e05ull, 0x992f42396f377ca0ull},
+  {1025, 0x9023021be9571bacull, 0x2c9b4ad3d1b7e5beull, 0x0e47b2afb4ed73c0ull},
+  {2048, 0x6987e70844d7d07aull, 0xff3886203cb1be12ull, 0x1fe995e57821594dull},
+  {4999, 0xebc484d7359ba33full, 0x8ba2c00a25bc501full, 0x6d677ae1494590e3ull}
+};
+
+} // namespace
+
+int main() {
+  std::vector<uint8_t> data(5000);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = uint8_t(i * 131 + 7);
+
+  for (auto& k : answers) {
+    auto h = hash_bytes128(data.data(), k.size);
+    IG_EXPECT(h.lo == k.lo && h.hi == k.hi);
+    IG_EXPECT(hash_bytes(data.data(), k.size, 0x1234) == k.seeded);
+
+    // unaligned input
+    std::vector<uint8_t> shifted(k.size + 1);
+    std::copy_n(data.data(), k.size, shifted.data() + 1);
+    IG_EXPECT(hash_bytes128(shifted.data() + 1, k.size) == h);
+  }
+
+  return test::result();
+}
@@ -0,0 +1,60 @@
+/*
+ Imagine v0.1
+ [test]
+ Copyright (c) 2015-present, Hugo (hrkz) Frezat
+*/
+
+#include "scenario.h"
+#include "imagine/math/theory/matrix.h"
+
+#include <cmath>
+
+using namespace ig;
+
+namespace {
+
+auto make(size_t n, float seed) {
+  matrix<float> mat(n, n);
+  for (size_t i = 0; i < mat.size(); ++i) mat[i] = std::fmod(seed * float(i + 1), 1.f) - 0.5f;
+  return mat;
+}
+
+// c = a % b element by element
+template <typename A, typename B>
+bool matches(const matrix<float>& c, const A& a, const B& b) {
+  for (size_t i = 0; i < c.rows(); ++i)
+    for (size_t j = 0; j < c.cols(); ++j) {
+      float s = 0;
+      for (size_t k = 0; k < a.cols(); ++k) s += a(i, k) * b(k, j);
+      if (std::abs(c(i, j) - s) > 1e-4f * (1 + std::abs(s))) return false;
+    } return true;
+}
+
+} // namespace
+
+int main() {
+  for (size_t n : {3, 8, 64}) {
+    auto a = make(n, 0.37f), b = make(n, 0.61f);
+
+    // products kept beyond the full expression of their temporary operands
+    auto p = make(n, 0.37f) % b;
+    auto q = a % make(n, 0.61f);
+    auto r = make(n, 0.37f) % make(n, 0.61f);
+    matrix<float> cp = p, cq = q, cr = r;
+    IG_EXPECT(matches(cp, a, b));
+    IG_EXPECT(matches(cq, a, b));
+    IG_EXPECT(matches(cr, a, b));
+
+    // lvalue operands are read when the product is assigned
+    auto s = a % b;
+    a[0] += 1.f;
+    matrix<float> cs = s;
+    IG_EXPECT(matches(cs, a, b));
+
+    auto c = a;
+    c %= b;
+    IG_EXPECT(matches(c, a, b));
+  }
+
+  return test::result();
+}
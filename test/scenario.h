@@ -7,4 +7,38 @@
 #ifndef IG_TEST_SCENARIO_H
 #define IG_TEST_SCENARIO_H
 
+#include <cstdio>
+#include <string>
+
+namespace ig   {
+namespace test {
+
+// Scenarios
+// each file of test is an executable, failed expectations are reported and counted, and main returns
+// the result of the run so that a failing scenario fails the test target
+inline auto& failures() { static int count = 0; return count; }
+
+inline void expect(bool cond, const char* what, const char* file, int line) {
+  if (cond) return;
+  std::fprintf(stderr, "%s:%d: expectation failed (%s)\n", file, line, what);
+  ++failures();
+}
+
+inline int result() { return failures() ? 1 : 0; }
+
+// scratch path of the run, removed by the caller
+inline auto temporary(const std::string& name) { return "/tmp/ig-test-" + name; }
+
+} // namespace test
+} // namespace ig
+
+#define IG_EXPECT(...) ig::test::expect(bool(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+#define IG_EXPECT_THROW(expr, error)                                                                        \
+  do {                                                                                                      \
+    bool thrown = false;                                                                                    \
+    try { expr; } catch (const error&) { thrown = true; }                                                   \
+    ig::test::expect(thrown, #expr " throws " #error, __FILE__, __LINE__);                                  \
+  } while (0)
+
 #endif // IG_TEST_SCENARIO_H